@@ -24,46 +24,180 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include "output.h"
 
 #include <cassert>
+#include <cstdlib>
+#include <cstdarg>
 
 using namespace std;
 
-int numPreconds(Action* a) {
-    if (!gcmd_line.reverse) 
-      return a->num_preconds;
-    else
-      return a->num_dels;
+ActionTable gaction_table;
+vector<const char*> gfact_names;
+
+void buildActionTable() {
+  ActionTable &t = gaction_table;
+  
+  t.pre_start.assign(1,0);
+  t.add_start.assign(1,0);
+  t.del_start.assign(1,0);
+  t.inst_start.assign(1,0);
+  t.pre_lits.clear();
+  t.add_lits.clear();
+  t.del_lits.clear();
+  t.op.clear();
+  t.inst.clear();
+  t.reversed = false;
+  
+  Action* a = gactions;
+  while (a) {
+    t.pre_lits.insert(t.pre_lits.end(),a->preconds,a->preconds+a->num_preconds);
+    t.pre_start.push_back(t.pre_lits.size());
+    t.add_lits.insert(t.add_lits.end(),a->adds,a->adds+a->num_adds);
+    t.add_start.push_back(t.add_lits.size());
+    t.del_lits.insert(t.del_lits.end(),a->dels,a->dels+a->num_dels);
+    t.del_start.push_back(t.del_lits.size());
+    
+    t.op.push_back(a->op);
+    t.inst.insert(t.inst.end(),a->inst_table,a->inst_table+goperators[a->op]->num_vars);
+    t.inst_start.push_back(t.inst.size());
+    
+    Action* next = a->next;
+    free(a->preconds);
+    free(a->adds);
+    free(a->dels);
+    free(a);
+    a = next;
   }
+  gactions = NULL;
   
-int getPrecond(Action* a, int i) {
-  if (!gcmd_line.reverse) 
-    return a->preconds[i];
-  else
-    return a->dels[i];
+  assert(t.op.size() == (size_t)gnum_actions);
+  
+  setActionDirection(gcmd_line.reverse);
+  buildAdderIndex(gnum_relevant_facts);
+}
+
+void buildAdderIndex(size_t num_lits) {
+  ActionTable &t = gaction_table;
+  
+  // counting sort of the (lit, action) pairs by lit
+  t.adder_start.assign(num_lits+1,0);
+  for (size_t i = 0; i < t.add_lits.size(); i++)
+    t.adder_start[t.add_lits[i]+1]++;
+  for (size_t lit = 0; lit < num_lits; lit++)
+    t.adder_start[lit+1] += t.adder_start[lit];
+  
+  t.adders.resize(t.add_lits.size());
+  vector<size_t> fill(t.adder_start.begin(),t.adder_start.end()-1);
+  size_t num_actions = t.add_start.size()-1;
+  for (size_t a = 0; a < num_actions; a++)
+    for (size_t i = t.add_start[a]; i < t.add_start[a+1]; i++)
+      t.adders[fill[t.add_lits[i]]++] = a;
 }
 
-int numAdds(Action* a) {  
-  return a->num_adds;  
+void setActionDirection(bool reverse) {
+  ActionTable &t = gaction_table;
+  
+  if (t.reversed != reverse) {
+    t.pre_start.swap(t.del_start);
+    t.pre_lits.swap(t.del_lits);
+    t.reversed = reverse;
+  }
 }
 
-int getAdd(Action* a, int i) {
-  return a->adds[i];  
+SlabPool::~SlabPool() {
+  for (size_t i = 0; i < slabs.size(); i++)
+    free(slabs[i]);
 }
 
-int numDels(Action* a) {
-  if (!gcmd_line.reverse) 
-    return a->num_dels;
-  else
-    return a->num_preconds;
+void SlabPool::newSlab(size_t at_least) {
+  // the rest of the current slab is given up
+  size_t bytes = (at_least > SLAB_BYTES) ? at_least : SLAB_BYTES;
+  cur = (char*)malloc(bytes);
+  if (!cur) {
+    printf("Out of memory!\n");
+    exit(1);
+  }
+  slabs.push_back(cur);
+  left = bytes;
+  reserved += bytes;
 }
 
-int getDel(Action* a, int i) {
-  if (!gcmd_line.reverse) 
-    return a->dels[i];
-  else
-    return a->preconds[i];
+WorkerPool::WorkerPool(size_t num_workers) : job(0), job_arg(0), generation(0), running(0), quit(false) {
+  pthread_mutex_init(&mutex,0);
+  pthread_cond_init(&job_posted,0);
+  pthread_cond_init(&job_done,0);
+  
+  assert(num_workers > 0);
+  threads.resize(num_workers-1);
+  starts.resize(num_workers-1);
+  for (size_t i = 0; i < threads.size(); i++) {
+    starts[i].pool = this;
+    starts[i].worker = i+1;
+    if (pthread_create(&threads[i],0,threadMain,&starts[i])) {
+      printf("Cannot create a worker thread!\n");
+      exit(1);
+    }
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  pthread_mutex_lock(&mutex);
+  quit = true;
+  pthread_cond_broadcast(&job_posted);
+  pthread_mutex_unlock(&mutex);
+  
+  for (size_t i = 0; i < threads.size(); i++)
+    pthread_join(threads[i],0);
+    
+  pthread_cond_destroy(&job_done);
+  pthread_cond_destroy(&job_posted);
+  pthread_mutex_destroy(&mutex);
+}
+
+void WorkerPool::run(WorkerJob j, void* arg) {
+  pthread_mutex_lock(&mutex);
+  job = j;
+  job_arg = arg;
+  generation++;
+  running = threads.size();
+  pthread_cond_broadcast(&job_posted);
+  pthread_mutex_unlock(&mutex);
+  
+  j(arg,0);
+  
+  pthread_mutex_lock(&mutex);
+  while (running)
+    pthread_cond_wait(&job_done,&mutex);
+  pthread_mutex_unlock(&mutex);
+}
+
+void* WorkerPool::threadMain(void* start) {
+  WorkerPool* pool = ((Start*)start)->pool;
+  size_t worker = ((Start*)start)->worker;
+  size_t seen = 0;
+  
+  pthread_mutex_lock(&pool->mutex);
+  for (;;) {
+    while (pool->generation == seen && !pool->quit)
+      pthread_cond_wait(&pool->job_posted,&pool->mutex);
+    if (pool->quit)
+      break;
+      
+    seen = pool->generation;
+    WorkerJob j = pool->job;
+    void* arg = pool->job_arg;
+    pthread_mutex_unlock(&pool->mutex);
+    
+    j(arg,worker);
+    
+    pthread_mutex_lock(&pool->mutex);
+    if (!(--pool->running))
+      pthread_cond_signal(&pool->job_done);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  
+  return 0;
 }
 
-bool clauseUnsatisfied(Clause const &cl, BoolState const &st) {
+bool clauseUnsatisfied(ClauseView cl, BoolState const &st) {
   for (size_t i = 0; i < cl.size(); i++)
     if (st[cl[i]])
       return false;
@@ -71,7 +205,109 @@ bool clauseUnsatisfied(Clause const &cl, BoolState const &st) {
   return true;
 }
 
-bool subsumes(Clause const &c1, Clause const &c2) { 
+void packClause(ClauseView cl, PackedClause &pcl) {
+  pcl.resize(cl.size());
+  if (cl.size())
+    pcl.resize(packClause(cl,&pcl[0]));
+}
+
+size_t packClause(ClauseView cl, PackedWord* pcl) {
+  size_t n = 0;
+  for (size_t i = 0; i < cl.size(); i++) {
+    size_t idx = cl[i] / STATE_WORD_BITS;
+    StateWord mask = (StateWord)1 << (cl[i] % STATE_WORD_BITS);
+    if (n && pcl[n-1].idx == idx)
+      pcl[n-1].mask |= mask;
+    else {
+      pcl[n].idx = idx;
+      pcl[n].mask = mask;
+      n++;
+    }
+  }
+  return n;
+}
+
+size_t packedClauseSize(ClauseView cl) {
+  size_t n = 0;
+  for (size_t i = 0; i < cl.size(); i++)
+    if (!i || cl[i] / STATE_WORD_BITS != cl[i-1] / STATE_WORD_BITS)
+      n++;
+  return n;
+}
+
+StateWord clauseSignature(ClauseView cl) {
+  StateWord sig = 0;
+  for (size_t i = 0; i < cl.size(); i++)
+    sig |= (StateWord)1 << (cl[i] % STATE_WORD_BITS);
+  return sig;
+}
+
+#ifdef PDR_TRACE
+bool TraceWriter::open(const char* name, size_t sample_every) {
+  out = fopen(name,"w");
+  if (!out)
+    return false;
+  start = nowNanos();
+  sample = sample_every ? sample_every : 1;
+  fprintf(out,"[\n");
+  return true;
+}
+
+void TraceWriter::close() {
+  if (!out)
+    return;
+  // the last event closes the array (the format doesn't mind a trace which was never closed, e.g. after an interrupt)
+  fprintf(out,"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"pdr\"}}\n]\n");
+  fclose(out);
+  out = 0;
+}
+
+void TraceWriter::complete(const char* cat, const char* name, int tid, uint64_t begin, uint64_t end, const char* args, ...) {
+  char buf[256];
+  va_list ap;
+  va_start(ap,args);
+  vsnprintf(buf,sizeof(buf),args,ap);
+  va_end(ap);
+  
+  fprintf(out,"{\"cat\":\"%s\",\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{%s}},\n",
+    cat,name,tid,(begin-start)*1e-3,(end-begin)*1e-3,buf);
+}
+#endif
+
+void printHistograms(FILE* out, vector<TimeStat> const& stats) {
+  size_t lo = TimeStat::NUM_BUCKETS, hi = 0;
+  for (size_t i = 0; i < stats.size(); i++)
+    for (size_t b = 0; b < TimeStat::NUM_BUCKETS; b++)
+      if (stats[i].buckets[b]) {
+        lo = min(lo,b);
+        hi = max(hi,b+1);
+      }
+  if (lo >= hi)
+    return;
+    
+  fprintf(out,"%8s","");
+  for (size_t b = lo; b < hi; b++)
+    if (b+1 == TimeStat::NUM_BUCKETS)
+      fprintf(out," %8s","longer");
+    else if (b < 10)
+      fprintf(out," %6zuus",(size_t)1 << b);
+    else if (b < 20)
+      fprintf(out," %6zums",(size_t)1 << (b-10)); // (binary milliseconds, close enough)
+    else
+      fprintf(out," %7zus",(size_t)1 << (b-20));
+  fprintf(out,"\n");
+  
+  for (size_t i = 0; i < stats.size(); i++) {
+    if (!stats[i].count)
+      continue;
+    fprintf(out,"%8zu",i);
+    for (size_t b = lo; b < hi; b++)
+      fprintf(out," %8zu",stats[i].buckets[b]);
+    fprintf(out,"\n");
+  }
+}
+
+bool subsumes(ClauseView c1, ClauseView c2) { 
   if (c1.size() > c2.size())
     return false;
 
@@ -89,29 +325,36 @@ bool subsumes(Clause const &c1, Clause const &c2) {
   return true;
 }
 
-bool actionApplicable(BoolState &state, Action* a) {
+bool actionApplicable(BoolState &state, size_t a) {
   for (int i = 0; i < numPreconds(a); i++)
     if (!state[getPrecond(a,i)])
       return false;
   return true;
 }
 
-void applyActionEffects(BoolState &state, Action* a) {
+void applyActionEffects(BoolState &state, size_t a) {
   for (int i = 0; i < numAdds(a); i++)
     state[getAdd(a,i)] = true;
   for (int i = 0; i < numDels(a); i++)
     state[getDel(a,i)] = false;  
 }
 
+void printFact(size_t lit) {
+  if (gfact_names.empty())
+    print_ft_name(lit);
+  else
+    printf("%s",gfact_names[lit]);
+}
+
 void printClause(Clause const & clause) {
   for (size_t i = 0; i < clause.size(); i++)
     printf("%zu, ",clause[i]);
   printf("\n");    
 }
 
-void printClauseNice(Clause const & clause) {
+void printClauseNice(ClauseView clause) {
   for (size_t i = 0; i < clause.size(); i++) {
-    print_ft_name(clause[i]);
+    printFact(clause[i]);
     printf(" ");
   }
   printf("\n"); 
@@ -138,7 +381,7 @@ void printClauseAsState(Clause const & clause) {
 void printState(BoolState const & state) {
   for (size_t i = 0; i < state.size(); i++)
     if (state[i]) {
-      print_ft_name(i);
+      printFact(i);
       printf(" ");
     }
   printf("\n"); 
@@ -169,18 +412,24 @@ void printStateHash(BoolState const & state) {
   printf("%d%c\n",cnt,'a'+cur);
 }
 
-void printAction(FILE* outfile, Action* a) {
-  Operator *o = goperators[a->op];
+void printAction(FILE* outfile, size_t a) {
+  if (!gaction_table.names.empty()) {
+    fprintf(outfile,"(%s)\n",gaction_table.names[a]);
+    return;
+  }
+  Operator *o = goperators[gaction_table.op[a]];
+  size_t inst = gaction_table.inst_start[a];
   fprintf(outfile,"(%s",o->name);
   for (int  i = 0; i < o->num_vars; i++ )
-    fprintf(outfile," %s",gconstants[a->inst_table[i]]);
+    fprintf(outfile," %s",gconstants[gaction_table.inst[inst+i]]);
   fprintf(outfile,")\n");  
 }
 
-void printGroundedAction(FILE* outfile, Action* a) {
-  Operator *o = goperators[a->op];
+void printGroundedAction(FILE* outfile, size_t a) {
+  Operator *o = goperators[gaction_table.op[a]];
+  size_t inst = gaction_table.inst_start[a];
   fprintf(outfile,"%s",o->name);
   for (int  i = 0; i < o->num_vars; i++ )
-    fprintf(outfile,"-%s",gconstants[a->inst_table[i]]);
+    fprintf(outfile,"-%s",gconstants[gaction_table.inst[inst+i]]);
   fprintf(outfile,"\n");  
 }
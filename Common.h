@@ -23,31 +23,403 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 
 #include "bb.h"
 #include <cstdio>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
 
 #include <vector>
+#include <algorithm>
 
-typedef std::vector<bool> BoolState;
 typedef std::vector<size_t> Clause; // only positive clauses -- implemented as a vector of their atom indices
 
-int numPreconds(Action* a);
-int getPrecond(Action* a, int i);
-int numAdds(Action* a);
-int getAdd(Action* a, int i);
-int numDels(Action* a);
-int getDel(Action* a, int i);
+typedef uint64_t StateWord;
+const size_t STATE_WORD_BITS = 64;
 
-bool subsumes(Clause const &c1, Clause const &c2); // assumed sorted
-bool clauseUnsatisfied(Clause const &cl, BoolState const &st);
-bool actionApplicable(BoolState &state, Action* a);
-void applyActionEffects(BoolState &state, Action* a);
+// A bit vector packed into 64-bit words.
+// Copying, clearing and filling work word-wise; the bits beyond size() in the last word are always kept zero.
+struct BoolState {
+  // proxy for writing single bits through operator[] (like std::vector<bool>::reference)
+  struct reference {
+    StateWord& word;
+    StateWord  mask;
 
+    reference(StateWord& w, StateWord m) : word(w), mask(m) {}
+
+    operator bool() const { return (word & mask) != 0; }
+    reference& operator=(bool val) { if (val) word |= mask; else word &= ~mask; return *this; }
+    reference& operator=(reference const& other) { return *this = (bool)other; }
+  };
+
+  BoolState() : nbits(0) {}
+  BoolState(size_t n, bool val) : nbits(0) { resize(n,val); }
+
+  size_t size() const { return nbits; }
+
+  bool operator[](size_t i) const { return (words[i / STATE_WORD_BITS] >> (i % STATE_WORD_BITS)) & 1; }
+  reference operator[](size_t i) { return reference(words[i / STATE_WORD_BITS],(StateWord)1 << (i % STATE_WORD_BITS)); }
+
+  void set(size_t i)   { words[i / STATE_WORD_BITS] |= (StateWord)1 << (i % STATE_WORD_BITS); }
+  void reset(size_t i) { words[i / STATE_WORD_BITS] &= ~((StateWord)1 << (i % STATE_WORD_BITS)); }
+
+  void clear() {
+    words.clear();
+    nbits = 0;
+  }
+
+  void resize(size_t n, bool val = false) {
+    size_t old = nbits;
+    words.resize((n + STATE_WORD_BITS - 1) / STATE_WORD_BITS,0);
+    nbits = n;
+    if (val && n > old) {
+      // finish the partially used word, then fill the whole ones after it
+      size_t i = old;
+      for (; i < n && i % STATE_WORD_BITS; i++)
+        set(i);
+      if (i < n)
+        std::fill(words.begin() + (i + STATE_WORD_BITS - 1) / STATE_WORD_BITS,words.end(),~(StateWord)0);
+    }
+    trim();
+  }
+
+  // set all the bits to val without reallocating
+  void fill(bool val) {
+    std::fill(words.begin(),words.end(),val ? ~(StateWord)0 : 0);
+    trim();
+  }
+
+  void swap(BoolState& other) {
+    words.swap(other.words);
+    std::swap(nbits,other.nbits);
+  }
+
+  // appends the indices of all the true bits to out (in increasing order)
+  void collectTrue(Clause& out) const {
+    for (size_t w = 0; w < words.size(); w++) {
+      StateWord bits = words[w];
+      while (bits) {
+        out.push_back(w * STATE_WORD_BITS + __builtin_ctzll(bits));
+        bits &= bits - 1;
+      }
+    }
+  }
+
+  size_t numWords() const { return words.size(); }
+  StateWord word(size_t w) const { return words[w]; }
+  
+  // raw access to the words, for storing a state elsewhere and loading it back
+  StateWord const* wordData() const { return words.empty() ? 0 : &words[0]; }
+  void assignWords(StateWord const* ws, size_t n) {
+    words.assign(ws,ws + (n + STATE_WORD_BITS - 1) / STATE_WORD_BITS);
+    nbits = n;
+  }
+
+  private:
+  std::vector<StateWord> words;
+  size_t nbits;
+
+  void trim() {
+    if (nbits % STATE_WORD_BITS)
+      words.back() &= ((StateWord)1 << (nbits % STATE_WORD_BITS)) - 1;
+  }
+};
+
+// A clause packed as a list of (word index, mask) pairs against the BoolState layout.
+// Testing whether the clause is false in a state then costs one AND per touched word instead of one lookup per literal.
+struct PackedWord {
+  size_t    idx;
+  StateWord mask;
+};
+
+typedef std::vector<PackedWord> PackedClause;
+
+// A read-only view of a sequence stored elsewhere: in a vector, or e.g. inline behind a pool allocated object.
+template <class T>
+struct Slice {
+  T const* ptr;
+  size_t   len;
+  
+  Slice() : ptr(0), len(0) {}
+  Slice(T const* p, size_t l) : ptr(p), len(l) {}
+  Slice(std::vector<T> const& v) : ptr(v.empty() ? 0 : &v[0]), len(v.size()) {}
+  
+  size_t size() const { return len; }
+  T const& operator[](size_t i) const { return ptr[i]; }
+};
+
+typedef Slice<size_t>     ClauseView;
+typedef Slice<PackedWord> PackedClauseView;
+
+// Allocator for many small objects of a few distinct sizes (clause boxes, obligations).
+// Memory is carved from large slabs and recycled through a free list per size; it only goes back to the system with the pool.
+// The caller passes the size also to release (the blocks carry no header).
+class SlabPool {
+  public:
+  SlabPool() : cur(0), left(0), in_use(0), reserved(0) {}
+  ~SlabPool();
+  
+  void* alloc(size_t bytes) {
+    size_t units = (bytes + UNIT - 1) / UNIT;
+    in_use += units*UNIT;
+    if (units < free_lists.size() && free_lists[units]) {
+      void* block = free_lists[units];
+      free_lists[units] = *(void**)block;
+      return block;
+    }
+    if (units*UNIT > left)
+      newSlab(units*UNIT);
+    void* block = cur;
+    cur += units*UNIT;
+    left -= units*UNIT;
+    return block;
+  }
+  
+  void release(void* block, size_t bytes) {
+    size_t units = (bytes + UNIT - 1) / UNIT;
+    in_use -= units*UNIT;
+    if (units >= free_lists.size())
+      free_lists.resize(units+1,0);
+    *(void**)block = free_lists[units];
+    free_lists[units] = block;
+  }
+  
+  size_t bytesInUse() const { return in_use; }
+  size_t bytesReserved() const { return reserved; }
+  
+  private:
+  static const size_t UNIT = sizeof(StateWord);    // allocation granularity (and alignment)
+  static const size_t SLAB_BYTES = 64*1024;
+  
+  std::vector<void*> free_lists;  // indexed by the block size in units
+  std::vector<char*> slabs;
+  char*  cur;                     // the unused rest of the last slab
+  size_t left;
+  size_t in_use, reserved;
+  
+  void newSlab(size_t at_least);
+  
+  SlabPool(SlabPool const&);            // not copyable
+  SlabPool& operator=(SlabPool const&);
+};
+
+const size_t NO_ACTION = (size_t)-1; // where an action index is expected, but there is none (e.g. for the no-op)
+
+// The ground actions in a compact, structure-of-arrays form: literals of all the actions stored in one array per kind.
+// Built once by buildActionTable from the (normalized) gactions list, which gets freed then;
+// an action is from then on referred to by its index 0 .. gnum_actions-1, following the order of the list.
+// The table is stored already in the search direction: in reverse mode the preconditions and deletes swap their roles,
+// which is resolved once by setActionDirection so that the accessors below need not look at gcmd_line.reverse.
+struct ActionTable {
+  // the preconditions of action a are pre_lits[pre_start[a]], ..., pre_lits[pre_start[a+1]-1]; same for the adds and dels
+  std::vector<size_t> pre_start, add_start, del_start;
+  std::vector<int>    pre_lits, add_lits, del_lits;
+  
+  bool reversed; // pre_* and del_* currently hold the dels and pres of the original actions
+  
+  // the reverse of the adds: the actions adding lit are adders[adder_start[lit]], ..., adders[adder_start[lit+1]-1]
+  std::vector<size_t> adder_start;
+  std::vector<size_t> adders;
+  
+  // for printing: action a instantiates goperators[op[a]] with the constants inst[inst_start[a]], ...
+  std::vector<int>    op;
+  std::vector<size_t> inst_start;
+  std::vector<int>    inst;
+  
+  // or, for a task loaded from a task cache (see TaskCache.h), is just called names[a] (op and inst are then empty)
+  std::vector<const char*> names;
+};
+
+extern ActionTable gaction_table;
+
+// the names of the facts of a task loaded from a task cache; empty when grounded by ourselves (print_ft_name works then)
+extern std::vector<const char*> gfact_names;
+
+void buildActionTable(); // in the direction given by gcmd_line.reverse
+void setActionDirection(bool reverse);
+void buildAdderIndex(size_t num_lits); // called by buildActionTable; again if the adds are changed
+
+inline int numPreconds(size_t a) {
+  return (int)(gaction_table.pre_start[a+1] - gaction_table.pre_start[a]);
+}
+
+inline int getPrecond(size_t a, int i) {
+  return gaction_table.pre_lits[gaction_table.pre_start[a]+i];
+}
+
+inline int numAdds(size_t a) {
+  return (int)(gaction_table.add_start[a+1] - gaction_table.add_start[a]);
+}
+
+inline int getAdd(size_t a, int i) {
+  return gaction_table.add_lits[gaction_table.add_start[a]+i];
+}
+
+inline size_t numAdders(size_t lit) {
+  return gaction_table.adder_start[lit+1] - gaction_table.adder_start[lit];
+}
+
+inline size_t getAdder(size_t lit, size_t i) {
+  return gaction_table.adders[gaction_table.adder_start[lit]+i];
+}
+
+inline int numDels(size_t a) {
+  return (int)(gaction_table.del_start[a+1] - gaction_table.del_start[a]);
+}
+
+inline int getDel(size_t a, int i) {
+  return gaction_table.del_lits[gaction_table.del_start[a]+i];
+}
+
+typedef void (*WorkerJob)(void* arg, size_t worker);
+
+// A fixed set of threads for running one job on all of them at once.
+// The calling thread takes part as worker 0; run returns after every worker has finished the job.
+class WorkerPool {
+  public:
+  WorkerPool(size_t num_workers); // including the calling thread
+  ~WorkerPool();
+  
+  size_t size() const { return threads.size()+1; }
+  
+  void run(WorkerJob job, void* arg);
+  
+  private:
+  struct Start {
+    WorkerPool* pool;
+    size_t worker;
+  };
+  
+  std::vector<pthread_t> threads;
+  std::vector<Start>     starts;
+  
+  pthread_mutex_t mutex;
+  pthread_cond_t  job_posted;
+  pthread_cond_t  job_done;
+  
+  // guarded by mutex
+  WorkerJob job;
+  void*     job_arg;
+  size_t    generation; // of the current job
+  size_t    running;    // threads still working on it
+  bool      quit;
+  
+  static void* threadMain(void* start);
+  
+  WorkerPool(WorkerPool const&);            // not copyable
+  WorkerPool& operator=(WorkerPool const&);
+};
+
+// the monotonic wall clock in nanoseconds; cheap enough (served without a system call) to time every single extend
+inline uint64_t nowNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+// the cpu time of the calling thread in nanoseconds (the process-wide one would also count the other members of a portfolio)
+inline uint64_t threadCpuNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+  return (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+// The time spent in one subsystem: the total and a histogram of the single measurements.
+// The buckets are logarithmic: bucket 0 counts the measurements under 1us, bucket i those in [2^(i-1),2^i) us, the last one also everything longer.
+struct TimeStat {
+  static const size_t NUM_BUCKETS = 26;
+  
+  uint64_t nanos;
+  size_t   count;
+  size_t   buckets[NUM_BUCKETS];
+  
+  TimeStat() { reset(); }
+  
+  void reset() {
+    nanos = 0;
+    count = 0;
+    std::fill(buckets,buckets+NUM_BUCKETS,0);
+  }
+  
+  void subtract(TimeStat const& other) {
+    nanos -= other.nanos;
+    count -= other.count;
+    for (size_t b = 0; b < NUM_BUCKETS; b++)
+      buckets[b] -= other.buckets[b];
+  }
+  
+  void add(uint64_t ns) {
+    nanos += ns;
+    count++;
+    buckets[bucketOf(ns)]++;
+  }
+  
+  double seconds() const { return nanos*1e-9; }
+  
+  static size_t bucketOf(uint64_t ns) {
+    uint64_t us = ns/1000;
+    if (!us)
+      return 0;
+    size_t b = 64 - __builtin_clzll(us);
+    return b < NUM_BUCKETS ? b : NUM_BUCKETS-1;
+  }
+};
+
+#ifdef PDR_TRACE
+// Writes Chrome trace events (the JSON array format, for Perfetto or chrome://tracing) to a file; compiled in only with PDR_TRACE.
+// Every event is written by a single call, so several contexts of a portfolio can share the writer (each as its own thread id).
+// The frequent kinds of events are sampled: sampled() says yes for every sample-th call.
+class TraceWriter {
+  public:
+  TraceWriter() : out(0), start(0), sample(1), counter(0) {}
+  
+  bool open(const char* name, size_t sample_every);
+  void close();
+  
+  bool sampled() { return out && __sync_fetch_and_add(&counter,1) % sample == 0; }
+  
+  // a complete event (ph "X") spanning from begin to end (nowNanos); args is the inside of the JSON args object, printf-like
+  void complete(const char* cat, const char* name, int tid, uint64_t begin, uint64_t end, const char* args, ...);
+  
+  bool active() const { return out != 0; }
+  
+  private:
+  FILE*    out;
+  uint64_t start;
+  size_t   sample;
+  size_t   counter;
+};
+#endif
+
+// one line per histogram (prefixed by its index) over the bucket range used by any of them, after a header with the bucket bounds
+void printHistograms(FILE* out, std::vector<TimeStat> const& stats);
+
+bool subsumes(ClauseView c1, ClauseView c2); // assumed sorted
+bool clauseUnsatisfied(ClauseView cl, BoolState const &st);
+
+void packClause(ClauseView cl, PackedClause &pcl); // assumed sorted
+size_t packClause(ClauseView cl, PackedWord* pcl); // the same into a buffer of packedClauseSize(cl) entries; returns that size
+size_t packedClauseSize(ClauseView cl);
+
+// a bloom-filter like summary of the literals; subsumes(c1,c2) implies (sig(c1) & ~sig(c2)) == 0
+StateWord clauseSignature(ClauseView cl);
+
+inline bool clauseUnsatisfied(PackedClauseView pcl, BoolState const &st) {
+  for (size_t i = 0; i < pcl.size(); i++)
+    if (st.word(pcl[i].idx) & pcl[i].mask)
+      return false;
+
+  return true;
+}
+bool actionApplicable(BoolState &state, size_t a);
+void applyActionEffects(BoolState &state, size_t a);
+
+void printFact(size_t lit); // like print_ft_name, but also for a task loaded from a task cache
 void printClause(Clause const & clause);
-void printClauseNice(Clause const & clause);
+void printClauseNice(ClauseView clause);
 void printClauseAsState(Clause const & clause);
 void printState(BoolState const & state);
 void printStateHash(BoolState const & state);
 
-void printAction(FILE* outfile, Action* a);
-void printGroundedAction(FILE* outfile, Action* a);
+void printAction(FILE* outfile, size_t a);
+void printGroundedAction(FILE* outfile, size_t a);
 
 #endif
\ No newline at end of file
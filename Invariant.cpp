@@ -74,7 +74,7 @@ static bool unit(int i) {
   return (clauses[i] && !clauses[i]->other);
 }
 
-static void loadA(Action* a) {
+static void loadA(size_t a) {
   for (int i = 0; i < numPreconds(a); i++) 
     playground[getPrecond(a,i)] |= FL_PRE;
     
@@ -85,7 +85,7 @@ static void loadA(Action* a) {
     playground[getDel(a,i)] |= FL_DEL;
 }
 
-static void unloadA(Action* a) {
+static void unloadA(size_t a) {
   for (int i = 0; i < numPreconds(a); i++) 
     playground[getPrecond(a,i)] = FL_NONE;
     
@@ -141,7 +141,7 @@ void invariant_Init(Clause& goal_condition) {
     
     // we can assume actions normalized: pre_a \cap add_a = \emptyset \land del_a \cap add_a = \emptyset
     
-    for (Action* a = gactions; a; a = a->next) {
+    for (size_t a = 0; a < (size_t)gnum_actions; a++) {
       loadA(a);
     
       // printAction(stdout,a); 
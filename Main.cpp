@@ -24,8 +24,10 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include "Common.h"
 #include "Translate.h"
 #include "Invariant.h"
+#include "TaskCache.h"
 
 #include <unistd.h>
+#include <sys/resource.h>
 
 #include <cassert>
 #include <signal.h>
@@ -33,24 +35,42 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include <cstring>
 #include <climits>
 #include <cerrno>
+#include <cstdarg>
 
-#include <list>
+#include <new>
 #include <algorithm>
 #include <string>
 
 using namespace std;
 
-/* refcounted wrapper for storing layer clauses */
+/* refcounted wrapper for storing layer clauses 
+   allocated from a SlabPool, with the literals and then their word-packed form stored right behind the box (see create) */
 struct ClauseBox {
-  Clause data;
+  StateWord sig;  // clauseSignature of the literals, for quick subsumption rejection
   
   size_t refcnt;
   size_t from, to;
   
-  ClauseBox(Clause const& cl, size_t f) : data(cl), refcnt(0), from(f), to(f) {}
+  size_t indexed; // in how many occurrence and watch lists of ClauseIndex the box still sits
+  size_t layer_pos; // the position in the layer being extended (as scanned: layers_delta, then layers_deriv), set by extend
+  
+  size_t num_lits;
+  size_t num_packed;
+  SlabPool* pool; // where the box goes back to
+  
+  static ClauseBox* create(SlabPool& pool, ClauseView cl, size_t f) {
+    size_t np = packedClauseSize(cl);
+    ClauseBox* clbox = new (pool.alloc(bytes(cl.size(),np))) ClauseBox(pool,cl,np,f);
+    copy(cl.ptr,cl.ptr+cl.size(),clbox->litsBegin());
+    packClause(cl,clbox->packedBegin());
+    return clbox;
+  }
+  
+  ClauseView lits() const { return ClauseView(litsBegin(),num_lits); }
+  PackedClauseView packed() const { return PackedClauseView(packedBegin(),num_packed); } // the same literals word-packed for fast evaluation in states
   
   ClauseBox* inc() { refcnt++; return this; }
-  void dec() { if (!(--refcnt)) delete this;}
+  void dec() { if (!(--refcnt)) pool->release(this,bytes(num_lits,num_packed)); }
   
   bool validAt(size_t idx) {
     return (from >= idx && idx >= to);
@@ -63,40 +83,175 @@ struct ClauseBox {
   void extendedTo(size_t idx) {
     from = idx;
   }  
+  
+  private:
+  ClauseBox(SlabPool& p, ClauseView cl, size_t np, size_t f) : sig(clauseSignature(cl)), refcnt(0), from(f), to(f), indexed(0), layer_pos(0), num_lits(cl.size()), num_packed(np), pool(&p) {}
+  
+  static size_t bytes(size_t nl, size_t np) { return sizeof(ClauseBox) + nl*sizeof(size_t) + np*sizeof(PackedWord); }
+  
+  size_t*       litsBegin()         { return (size_t*)(this+1); }
+  size_t const* litsBegin() const   { return (size_t const*)(this+1); }
+  PackedWord*       packedBegin()       { return (PackedWord*)(litsBegin()+num_lits); }
+  PackedWord const* packedBegin() const { return (PackedWord const*)(litsBegin()+num_lits); }
 };
 
 typedef vector<ClauseBox*> Clauses;
 
+/* for every literal the layer clauses containing it (occurrence lists)
+   and, for subsumption checks, the layer clauses watching it (every clause watches a single one of its literals)
+   
+   while a box sits in at least one of the lists, the index holds a single refcount point on it;
+   a box no longer held by any layer (refcnt == 1) is only dropped lazily, when encountered in a traversal, or by collectGarbage
+   boxes in the lists are of all the layers - validAt should be checked by the users */
+struct ClauseIndex {
+  void resize(size_t sigsize) {
+    occs.resize(sigsize);
+    watches.resize(sigsize);
+  }
+
+  void insert(ClauseBox* clbox) {
+    assert(!clbox->indexed);
+    assert(clbox->num_lits);
+    clbox->inc();
+    clbox->indexed = clbox->num_lits+1;
+    size_t watch = clbox->lits()[0];
+    for (size_t i = 0; i < clbox->num_lits; i++) {
+      size_t lit = clbox->lits()[i];
+      occs[lit].push_back(clbox);
+      if (watches[lit].size() < watches[watch].size()) // keep the watch lists short
+        watch = lit;
+    }
+    watches[watch].push_back(clbox);
+  }
+  
+  Clauses& operator[](size_t lit) {
+    return occs[lit];
+  }
+  
+  Clauses& watching(size_t lit) {
+    return watches[lit];
+  }
+  
+  // no longer used by the layers, and only waiting to be dropped
+  static bool isDead(ClauseBox const* clbox) {
+    return clbox->refcnt <= 1;
+  }
+  
+  // if the j-th box in list (one of ours) is dead, removes it (by moving the last one in its place) and returns true
+  bool dropIfDead(Clauses& list, size_t j) {
+    ClauseBox* clbox = list[j];
+    if (!isDead(clbox))
+      return false;
+    list[j] = list.back();
+    list.pop_back();
+    if (!(--clbox->indexed))
+      clbox->dec();
+    return true;
+  }
+  
+  bool dropIfDead(size_t lit, size_t j) {
+    return dropIfDead(occs[lit],j);
+  }
+  
+  void collectGarbage() {
+    for (size_t lit = 0; lit < occs.size(); lit++) {
+      for (size_t j = 0; j < occs[lit].size(); )
+        if (!dropIfDead(occs[lit],j))
+          j++;
+      for (size_t j = 0; j < watches[lit].size(); )
+        if (!dropIfDead(watches[lit],j))
+          j++;
+    }
+  }
+  
+  private:
+  vector<Clauses> occs;
+  vector<Clauses> watches;
+};
+
 static void pruneInvalid(Clauses &layer, size_t layer_idx) {
   size_t j = 0;
   for (size_t i = 0; i < layer.size(); i++)
     if (layer[i]->validAt(layer_idx))
       layer[j++] = layer[i];
     else {
-      // printf("Clause no longer valid in layer %zu: ",layer_idx); printClauseNice(layer[i]->data);                
+      // printf("Clause no longer valid in layer %zu: ",layer_idx); printClauseNice(layer[i]->lits());                
       layer[i]->dec();
     }
   layer.resize(j);    
 }
 
+/* an obligation does not normally store its state, only the action leading to it from the parent;
+   the state is stored (right behind the obligation) only at checkpoints, see SolvingContext::newObligation and oblState */
 struct Obligation {
   size_t depth;
-  BoolState state;
     
   Obligation* parent;
-  Action *action;
+  size_t action;
+  
+  size_t refcnt;    // one point for the owner (a queue, or whoever took the obligation out of it) and one for every child
+  size_t num_words; // of the stored state; 0 if the obligation is not a checkpoint
+  
+  Obligation* prev; // the neighbours in the Obligations queue the obligation currently sits in
+  Obligation* next;
   
-  Obligation(Obligation* p, Action* a) : parent(p), action(a) {}
+  Obligation(Obligation* p, size_t a, size_t nw) : depth(p ? p->depth+1 : 0), parent(p), action(a), refcnt(1), num_words(nw), prev(0), next(0) {}
+  
+  StateWord*       stateWords()       { return (StateWord*)(this+1); }
+  StateWord const* stateWords() const { return (StateWord const*)(this+1); }
+  
+  static size_t bytes(size_t nw) { return sizeof(Obligation) + nw*sizeof(StateWord); }
 };
 
-typedef list<Obligation*> Obligations;
+/* intrusive doubly linked queue of obligations; an obligation sits in at most one queue at a time
+   being in a queue stands for the owner's refcount point of the obligation (see SolvingContext::newObligation and releaseObligation) */
+struct Obligations {
+  Obligations() : head(0), tail(0), count(0) {}
+  
+  bool empty() const { return !count; }
+  size_t size() const { return count; }
+  
+  Obligation* front() const { return head; }
+  Obligation* back() const { return tail; }
+  
+  void push_back(Obligation* obl) {
+    obl->prev = tail;
+    obl->next = 0;
+    if (tail) tail->next = obl; else head = obl;
+    tail = obl;
+    count++;
+  }
+  
+  void push_front(Obligation* obl) {
+    obl->prev = 0;
+    obl->next = head;
+    if (head) head->prev = obl; else tail = obl;
+    head = obl;
+    count++;
+  }
+  
+  void remove(Obligation* obl) {
+    if (obl->prev) obl->prev->next = obl->next; else head = obl->next;
+    if (obl->next) obl->next->prev = obl->prev; else tail = obl->prev;
+    obl->prev = obl->next = 0;
+    count--;
+  }
+  
+  void pop_front() { remove(head); }
+  void pop_back()  { remove(tail); }
+  
+  private:
+  Obligation* head;
+  Obligation* tail;
+  size_t count;
+};
 
 // Helper class to store more than one clause in a continuous vector
 // it works like a "stream" where we always record the clause's size and then its literals
 struct ClauseBuffer {
   vector<size_t> clauses;  
   size_t num_clauses;
-  Action* action;
+  size_t action;
   
   ClauseBuffer() : num_clauses(0) {}  
   
@@ -104,6 +259,12 @@ struct ClauseBuffer {
     num_clauses = 0;
     clauses.clear();
   }
+  
+  void swap(ClauseBuffer& other) {
+    clauses.swap(other.clauses);
+    std::swap(num_clauses,other.num_clauses);
+    std::swap(action,other.action);
+  }
 };
 
 // Helper class to store more than one binary (or unary) clause in a continuous vector
@@ -138,10 +299,43 @@ struct BinClauseBuffer {
     return data.size() >> 1;
   }
   
+  bool clauseUnsatisfied(size_t idx, BoolState const& st) {
+    idx *= 2;
+    assert(idx < data.size());
+    return !st[data[idx]] && !st[data[idx+1]];
+  }
+  
   void swap(BinClauseBuffer& other) {
     data.swap(other.data);
+    occ_start.swap(other.occ_start);
+    occ_clauses.swap(other.occ_clauses);
+  }
+  
+  // occurrence lists: indices of the clauses containing lit are occClause(j) for occBegin(lit) <= j < occEnd(lit)
+  // not maintained by the modifying methods; call again after the buffer changed
+  void buildOccurrences(size_t sigsize) {
+    occ_start.assign(sigsize+1,0);
+    for (size_t i = 0; i < data.size(); i += 2) {
+      occ_start[data[i]+1]++;
+      if (data[i] != data[i+1])
+        occ_start[data[i+1]+1]++;
+    }
+    for (size_t l = 0; l < sigsize; l++)
+      occ_start[l+1] += occ_start[l];
+    
+    occ_clauses.resize(occ_start[sigsize]);
+    vector<size_t> fill(occ_start.begin(),occ_start.end()-1);
+    for (size_t i = 0; i < data.size(); i += 2) {
+      occ_clauses[fill[data[i]]++] = i >> 1;
+      if (data[i] != data[i+1])
+        occ_clauses[fill[data[i+1]]++] = i >> 1;
+    }
   }
   
+  size_t occBegin(size_t lit) const { return occ_start[lit]; }
+  size_t occEnd(size_t lit) const { return occ_start[lit+1]; }
+  size_t occClause(size_t j) const { return occ_clauses[j]; }
+  
   void reserve(size_t sz) {
     data.reserve(sz << 1);
   }
@@ -181,20 +375,222 @@ struct BinClauseBuffer {
   vector<size_t> data;
   //stores (data.size() / 2) many binary (or unary) clauses
   //unary clauses are represented by repeating the same literal twice   
+  
+  vector<size_t> occ_start;
+  vector<size_t> occ_clauses;
+};
+
+
+/*
+ the clauses derived by the members of a cooperative portfolio (-k), one outbox per member
+ an outbox is a list of blocks that is only ever appended to by its owner and read by the others without locking:
+ an entry (layer index, number of literals, the literals) is written first and then published by moving the block's end;
+ a block is complete before the next one is linked behind it, and nothing is freed before the portfolio is over
+*/
+struct ClauseExchange {
+  struct Block {
+    static const size_t WORDS = 1 << 14;
+    
+    size_t          words[WORDS];
+    volatile size_t used;
+    Block* volatile next;
+    
+    Block() : used(0), next(0) {}
+  };
+  
+  struct Cursor {
+    Block* block;
+    size_t pos;
+  };
+  
+  vector<Block*> first; // per member
+  vector<Block*> last;
+  
+  ClauseExchange(size_t members) : first(members), last(members) {
+    for (size_t i = 0; i < members; i++)
+      first[i] = last[i] = new Block;
+  }
+  
+  ~ClauseExchange() {
+    for (size_t i = 0; i < first.size(); i++)
+      while (first[i]) {
+        Block* next = first[i]->next;
+        delete first[i];
+        first[i] = next;
+      }
+  }
+  
+  Cursor begin(size_t member) {
+    Cursor cur = { first[member], 0 };
+    return cur;
+  }
+  
+  // by the owner of the outbox only
+  void publish(size_t member, size_t layer_idx, ClauseView cl) {
+    assert(cl.size() + 2 <= Block::WORDS);
+    Block* blk = last[member];
+    bool fresh = blk->used + cl.size() + 2 > Block::WORDS;
+    if (fresh)
+      blk = new Block;
+      
+    size_t pos = blk->used;
+    blk->words[pos++] = layer_idx;
+    blk->words[pos++] = cl.size();
+    for (size_t i = 0; i < cl.size(); i++)
+      blk->words[pos++] = cl[i];
+    __sync_synchronize();
+    blk->used = pos;
+    
+    if (fresh) {
+      __sync_synchronize();
+      last[member]->next = blk;
+      last[member] = blk;
+    }
+  }
+  
+  // the next clause published behind cur, if any
+  bool fetch(Cursor& cur, size_t& layer_idx, Clause& cl) {
+    for (;;) {
+      Block* next = cur.block->next; // read before used, so that nothing published before the switch gets missed
+      __sync_synchronize();
+      if (cur.pos < cur.block->used) {
+        size_t* entry = cur.block->words + cur.pos;
+        layer_idx = entry[0];
+        cl.assign(entry+2,entry+2+entry[1]);
+        cur.pos += 2 + entry[1];
+        return true;
+      }
+      if (!next)
+        return false;
+      cur.block = next;
+      cur.pos = 0;
+    }
+  }
+};
+
+// shared by the members of a portfolio (-P): the first one to finish claims the answer and the others stop
+struct Portfolio {
+  volatile int    winner;    // index of the member which answered, -1 while still running
+  volatile sig_atomic_t interrupted; // set by SIGINT_exit: all the members stop and nobody answers
+  ClauseExchange* exchange;  // 0 unless the members share their clauses
+  
+  Portfolio() : winner(-1), interrupted(0), exchange(0) {}
+};
+
+// the statistics counters of a search; they only grow, each report shows the difference from the previous one of its kind
+struct SearchStats {
+  size_t oblig_processed;  
+  size_t oblig_sat;  
+  size_t oblig_side;
+  size_t oblig_unsat;
+  size_t oblig_subsumed;  
+  size_t oblig_killed;
+  
+  size_t cla_derived;
+  size_t cla_second;
+  size_t cla_subsumed;
+  size_t cla_pushed;
+  size_t cla_exported;
+  size_t cla_imported;
+  size_t cla_rejected;
+  
+  size_t minim_attempted;
+  size_t minim_litkilled;
+  
+  TimeStat time_extend_sat;
+  TimeStat time_extend_side;
+  TimeStat time_extend_uns;
+  TimeStat time_minimizing;    // (a part of time_extend_uns)
+  TimeStat time_subsumption;   // inserting the derived (and imported) clauses into the layers
+  TimeStat time_pushing;       // one measurement per phase
+  double   time_pushing_cpu;   // the same for all the threads of the context together, in seconds
+  TimeStat time_postprocessing;
+  
+  vector<TimeStat> extend_latency; // of all the extend calls, per layer index
+  
+  SearchStats() : oblig_processed(0), oblig_sat(0), oblig_side(0), oblig_unsat(0), oblig_subsumed(0), oblig_killed(0),
+                  cla_derived(0), cla_second(0), cla_subsumed(0), cla_pushed(0), cla_exported(0), cla_imported(0), cla_rejected(0),
+                  minim_attempted(0), minim_litkilled(0), time_pushing_cpu(0.0) {}
+  
+  // the counts since then, when this were the state at an earlier time
+  SearchStats since(SearchStats const& then) const {
+    SearchStats d = *this;
+    d.oblig_processed -= then.oblig_processed;
+    d.oblig_sat -= then.oblig_sat;
+    d.oblig_side -= then.oblig_side;
+    d.oblig_unsat -= then.oblig_unsat;
+    d.oblig_subsumed -= then.oblig_subsumed;
+    d.oblig_killed -= then.oblig_killed;
+    
+    d.cla_derived -= then.cla_derived;
+    d.cla_second -= then.cla_second;
+    d.cla_subsumed -= then.cla_subsumed;
+    d.cla_pushed -= then.cla_pushed;
+    d.cla_exported -= then.cla_exported;
+    d.cla_imported -= then.cla_imported;
+    d.cla_rejected -= then.cla_rejected;
+    
+    d.minim_attempted -= then.minim_attempted;
+    d.minim_litkilled -= then.minim_litkilled;
+    
+    d.time_extend_sat.subtract(then.time_extend_sat);
+    d.time_extend_side.subtract(then.time_extend_side);
+    d.time_extend_uns.subtract(then.time_extend_uns);
+    d.time_minimizing.subtract(then.time_minimizing);
+    d.time_subsumption.subtract(then.time_subsumption);
+    d.time_pushing.subtract(then.time_pushing);
+    d.time_pushing_cpu -= then.time_pushing_cpu;
+    d.time_postprocessing.subtract(then.time_postprocessing);
+    
+    for (size_t i = 0; i < then.extend_latency.size(); i++)
+      d.extend_latency[i].subtract(then.extend_latency[i]);
+    return d;
+  }
 };
 
+#ifdef PDR_TRACE
+// the trace export (-T), shared by all the contexts; defined before the global context, so that it is closed after the context's last events
+static struct GlobalTrace : TraceWriter {
+  ~GlobalTrace() { close(); }
+} gtrace;
+#endif
 
 struct SolvingContext {
+  // declared first to be destroyed last
+  SlabPool clause_pool;      // for the ClauseBoxes
+  SlabPool obligation_pool;  // for the Obligations
+  
+  struct _command_line cfg;  // the options this context runs with (a copy of gcmd_line, possibly varied in a portfolio)
+  FILE* output;              // where the progress and the statistics go
+  FILE* stats_stream;        // where a JSON record of the statistics goes after every phase (-J), if anywhere; may be shared in a portfolio
+  
+  // the random orderings come from the context's own generator, started from rng_seed (-z), so that a run can be repeated exactly
+  unsigned rng_seed;
+  unsigned rng_state;
+  
+  // the replay log (-w / -y) lists every random number drawn; when replaying, the numbers are read from it instead of the generator
+  FILE* replay_log;
+  bool  replaying;
+  
+  Portfolio* portfolio;      // 0 when running alone
+  int        portfolio_idx;
+  
+  vector<ClauseExchange::Cursor> import_cursors; // per member of the portfolio, when sharing clauses
+  Clause       import_clause;                    // temporaries for importClauses
+  PackedClause import_packed;
+  
   size_t phase;
 
   size_t sigsize;
   BoolState start_state;
   
-  // intialized only when (gcmd_line.minimize > 1)
+  // intialized only when (cfg.minimize > 1)
   BoolState goal_lits;   // true if the lit should be true in the goal state; used for efficient inductive minimization
   
   BinClauseBuffer invariant;  
   
+  ClauseIndex clause_index; // occurrences of literals in the clauses of all the layers (delta and deriv alike)
+  
   // clause sitting primarily here:
   vector< Clauses > layers_delta;     // size == phase+1, i.e. phase is a valid index into the last layer  
   // clauses coming here from weaker layers:
@@ -204,39 +600,40 @@ struct SolvingContext {
   vector< Obligations > obligations;  // size == phase
   Obligations obl_grave;
   
-  // statistics
-  size_t oblig_processed;  
-  size_t oblig_sat;  
-  size_t oblig_side;
-  size_t oblig_unsat;
-  size_t oblig_subsumed;  
-  size_t oblig_killed;
+  // the state of the last obligation loaded by oblState (if still alive), most likely the parent or a sibling of the next one
+  Obligation* cached_obl;
+  BoolState   cached_state;
   
-  size_t cla_derived;
-  size_t cla_second;
-  size_t cla_subsumed;
-  size_t cla_pushed;
+  vector<Obligation*> obl_path; // temporary for oblState
+  BoolState obl_state;          // temporary for the states of queued obligations
   
-  size_t minim_attempted;
-  size_t minim_litkilled;
+  size_t obl_alive;  // for the memory report
+  size_t obl_stored; // how many of the alive obligations store their state
+  
+#ifdef PDR_TRACE
+  TraceWriter* trace;          // 0 when not tracing
+  uint64_t     trace_phase_start;
+  size_t       extend_scanned; // how many actions the last extend tried
+#endif
   
-  float time_extend_sat;
-  float time_extend_uns;
-  float time_pushing;
-  float time_postprocessing;
+  SearchStats stats;          // since the start
+  SearchStats stats_printed;  // at the last printStat
+  SearchStats stats_recorded; // at the last record written to the statistics stream
   
   size_t path_min_layer;       // this one is for statistics
   size_t least_affected_layer; // this one is for speeding up clause propagation (otherwise more or less the same!)
   
-  SolvingContext() : phase(0), sigsize(0),
-                     oblig_processed(0), oblig_sat(0), oblig_side(0), oblig_unsat(0), oblig_subsumed(0), oblig_killed(0),
-                     cla_derived(0), cla_second(0), cla_subsumed(0), cla_pushed(0),
-                     minim_attempted(0), minim_litkilled(0),
-                     time_extend_sat(0.0), time_extend_uns(0.0), time_pushing(0.0), time_postprocessing(0.0),
+  SolvingContext() : output(stdout), stats_stream(0), rng_seed(1), rng_state(1), replay_log(0), replaying(false), portfolio(0), portfolio_idx(0),
+                     phase(0), sigsize(0), cached_obl(0), obl_alive(0), obl_stored(0),
                      path_min_layer(1),
-                     least_affected_layer(1)
+                     least_affected_layer(1),
+                     workers(0)
   {
-  
+#ifdef PDR_TRACE
+    trace = 0;
+    trace_phase_start = 0;
+    extend_scanned = 0;
+#endif
   }
   
   ~SolvingContext() {    
@@ -249,40 +646,104 @@ struct SolvingContext {
       for (size_t j = 0; j < layers_deriv[i].size(); j++)
         layers_deriv[i][j]->dec();        
     }
+    clause_index.collectGarbage(); // now drops all
+    
+    delete workers;
+    
+    if (replay_log)
+      fclose(replay_log);
         
     // obligations
     for (size_t i = 0; i < obligations.size(); i++)
-      for (Obligations::iterator j = obligations[i].begin(); j != obligations[i].end(); ++j)           
-        delete *j;
+      while (!obligations[i].empty()) {
+        Obligation* obl = obligations[i].front();
+        obligations[i].pop_front();
+        releaseObligation(obl);
+      }
         
     // and the grave
-    for (Obligations::iterator j = obl_grave.begin(); j != obl_grave.end(); ++j)           
-      delete *j;    
+    while (!obl_grave.empty()) {
+      Obligation* obl = obl_grave.front();
+      obl_grave.pop_front();
+      releaseObligation(obl);
+    }
+  }
+  
+  // only every OBL_CHECKPOINT-th level of the obligation trees stores the full state,
+  // so that reconstructing a state (see oblState) never needs to replay more than OBL_CHECKPOINT-1 actions
+  static const size_t OBL_CHECKPOINT = 16;
+  
+  // the new obligation is reached from parent by action and its state is state (the roots have no parent)
+  Obligation* newObligation(Obligation* parent, size_t action, BoolState const& state) {
+    bool checkpoint = !parent || (parent->depth+1) % OBL_CHECKPOINT == 0;
+    size_t nw = checkpoint ? state.numWords() : 0;
+    
+    Obligation* obl = new (obligation_pool.alloc(Obligation::bytes(nw))) Obligation(parent,action,nw);
+    if (nw) {
+      copy(state.wordData(),state.wordData()+nw,obl->stateWords());
+      obl_stored++;
+    }
+    if (parent)
+      parent->refcnt++;
+    obl_alive++;
+    
+    return obl;
+  }
+  
+  // drop the owner's refcount point; the obligation is freed only when none of its children (which need it for their states and the plan) is alive
+  void releaseObligation(Obligation* obl) {
+    while (obl && !(--obl->refcnt)) {
+      Obligation* parent = obl->parent;
+      
+      if (obl == cached_obl)
+        cached_obl = 0;
+      if (obl->num_words)
+        obl_stored--;
+      obl_alive--;
+      
+      obligation_pool.release(obl,Obligation::bytes(obl->num_words));
+      obl = parent;
+    }
   }
   
+  // reconstruct the state of obl into out (which must not be cached_state) by replaying the actions from the closest ancestor with a known state
+  void oblState(Obligation* obl, BoolState& out) {
+    obl_path.clear();
+    while (obl != cached_obl && !obl->num_words) {
+      obl_path.push_back(obl);
+      obl = obl->parent;
+    }
+    if (obl == cached_obl)
+      out = cached_state;
+    else
+      out.assignWords(obl->stateWords(),sigsize);
+      
+    for (size_t i = obl_path.size(); i > 0; i--)
+      applyActionEffects(out,obl_path[i-1]->action);
+  }
+  
+  // the counts are those since the previous call
   void printStat(bool between_phases = true) {             
+    SearchStats d = stats.since(stats_printed);
+    stats_printed = stats;
+    
     // Obligations
     {
-      printf("\nObligations:\n");
-      printf("\t%zu processed,\n",oblig_processed);      
-      printf("\t%zu extended,\n",oblig_sat);
-      printf("\t%zu sidestepped,\n",oblig_side);  
-      printf("\t%zu blocked,\n",oblig_unsat);
-      if (gcmd_line.obl_subsumption == 2)
-        printf("\t%zu subsumed (%zu extra killed).\n",oblig_subsumed,oblig_killed);      
+      fprintf(output,"\nObligations:\n");
+      fprintf(output,"\t%zu processed,\n",d.oblig_processed);      
+      fprintf(output,"\t%zu extended,\n",d.oblig_sat);
+      fprintf(output,"\t%zu sidestepped,\n",d.oblig_side);  
+      fprintf(output,"\t%zu blocked,\n",d.oblig_unsat);
+      if (cfg.obl_subsumption == 2)
+        fprintf(output,"\t%zu subsumed (%zu extra killed).\n",d.oblig_subsumed,d.oblig_killed);      
       else
-        printf("\t%zu subsumed.\n",oblig_subsumed);      
-      if (gcmd_line.obl_survive == 2 || gcmd_line.obl_subsumption == 2)
-        printf("\n\t%zu obligations in the grave.\n",obl_grave.size());
-            
-      // The following are reset after the timing report:
-      // oblig_processed = 0;
-      // oblig_sat = 0;      
-      // oblig_side = 0;
-      // oblig_unsat = 0;           
-      
-      oblig_subsumed = 0;
-      oblig_killed = 0;
+        fprintf(output,"\t%zu subsumed.\n",d.oblig_subsumed);      
+      if (cfg.obl_survive == 2 || cfg.obl_subsumption == 2)
+        fprintf(output,"\n\t%zu obligations in the grave.\n",obl_grave.size());
+        
+      size_t state_bytes = start_state.numWords()*sizeof(StateWord);  
+      fprintf(output,"\n\t%zu obligations alive, %zu of them storing the state; %zu KB in use (%zu KB saved against storing all the states).\n",
+        obl_alive,obl_stored,obligation_pool.bytesInUse()/1024,(obl_alive-obl_stored)*state_bytes/1024);
     }   
     
     // Clauses
@@ -293,81 +754,159 @@ struct SolvingContext {
       for (size_t i = 1; i < layers_delta.size(); i++) 
         for (size_t j = 0; j < layers_delta[i].size(); j++) {
           cla_kept++;
-          cla_lensum += layers_delta[i][j]->data.size();
+          cla_lensum += layers_delta[i][j]->num_lits;
         }
           
-      printf("\nClauses:\n");      
-      printf("\t%zu derived,\n",cla_derived);
-      printf("\t%zu subsumed,\n",cla_subsumed);
-      printf("\t%zu pushed,\n",cla_pushed);      
-      printf("\t%zu kept (average size %f lits ).\n",cla_kept,cla_lensum*(1.0/cla_kept));
-
-      cla_derived = 0;
-      cla_second = 0;
-      cla_subsumed = 0;
-      cla_pushed = 0;
+      fprintf(output,"\nClauses:\n");      
+      fprintf(output,"\t%zu derived,\n",d.cla_derived);
+      fprintf(output,"\t%zu subsumed,\n",d.cla_subsumed);
+      fprintf(output,"\t%zu pushed,\n",d.cla_pushed);      
+      if (portfolio && portfolio->exchange)
+        fprintf(output,"\t%zu shared, %zu imported (%zu rejected as known or not inductive here),\n",d.cla_exported,d.cla_imported,d.cla_rejected);
+      fprintf(output,"\t%zu kept (average size %f lits ).\n",cla_kept,cla_lensum*(1.0/cla_kept));
     }
             
     // Minimization (if applicable)
-    if (gcmd_line.minimize) {
-      printf("\nMinimization success rate: %f lits per attempt.\n",minim_litkilled*(1.0/minim_attempted));
-      minim_attempted = 0;
-      minim_litkilled = 0;                        
+    if (cfg.minimize) {
+      fprintf(output,"\nMinimization success rate: %f lits per attempt.\n",d.minim_litkilled*(1.0/d.minim_attempted));
     }
     
     // Model if (between_phases)    
     
     // Layer
     {  
-      printf("\nLayers: ");      
+      fprintf(output,"\nLayers: ");      
       assert(layers_delta.size() == layers_deriv.size());
       for (size_t i = 0; i < layers_delta.size(); i++) {            
         size_t layer_lensum = 0;
         for (size_t j = 0; j < layers_delta[i].size(); j++)          
-          layer_lensum += layers_delta[i][j]->data.size();          
+          layer_lensum += layers_delta[i][j]->num_lits;          
         
         pruneInvalid(layers_deriv[i],i);
-        printf("%zu+%zu",layers_delta[i].size(),layers_deriv[i].size());        
+        fprintf(output,"%zu+%zu",layers_delta[i].size(),layers_deriv[i].size());        
                                   
         if (layers_delta[i].size())
-          printf(" s%zu",layer_lensum/layers_delta[i].size());          
+          fprintf(output," s%zu",layer_lensum/layers_delta[i].size());          
         else 
-          printf(" s-");          
+          fprintf(output," s-");          
         
         if (i < layers_delta.size()-1)
-          printf(" | ");
+          fprintf(output," | ");
         else
-          printf("\n");        
+          fprintf(output,"\n");        
       }        
     }
         
     // Timing
     {
-      printf("\nTiming:\n");
-      printf("\t%fs spent extending (%f calls per second),\n",time_extend_sat+time_extend_uns,oblig_processed/(time_extend_sat+time_extend_uns));
-      printf("\t%fs SAT (%f calls per second),\n",time_extend_sat,(oblig_sat+oblig_side)/time_extend_sat);
-      printf("\t%fs UNS (%f calls per second),\n",time_extend_uns,oblig_unsat/time_extend_uns);
-      printf("\t%fs spent pushing.\n",time_pushing);
-      if (gcmd_line.postprocess && !between_phases) 
-        printf("\t%fs spent postprocessing the plan.\n",time_postprocessing);                
-                   
-      time_extend_sat = 0.0;
-      time_extend_uns = 0.0;
-      time_pushing = 0.0;
-      oblig_processed = 0;      
-      oblig_sat = 0;  
-      oblig_side = 0;
-      oblig_unsat = 0;           
+      fprintf(output,"\nTiming:\n");
+      double time_extend = d.time_extend_sat.seconds()+d.time_extend_side.seconds()+d.time_extend_uns.seconds();
+      fprintf(output,"\t%fs spent extending (%f calls per second),\n",time_extend,d.oblig_processed/time_extend);
+      fprintf(output,"\t%fs SAT (%f calls per second),\n",d.time_extend_sat.seconds(),d.oblig_sat/d.time_extend_sat.seconds());
+      fprintf(output,"\t%fs side (%f calls per second),\n",d.time_extend_side.seconds(),d.oblig_side/d.time_extend_side.seconds());
+      fprintf(output,"\t%fs UNS (%f calls per second),\n",d.time_extend_uns.seconds(),d.oblig_unsat/d.time_extend_uns.seconds());
+      if (cfg.minimize)
+        fprintf(output,"\t%fs of that minimizing,\n",d.time_minimizing.seconds());
+      fprintf(output,"\t%fs inserting clauses (subsumption),\n",d.time_subsumption.seconds());
+      if (workers)
+        fprintf(output,"\t%fs spent pushing (%fs cpu, parallel efficiency %.1f%%).\n",d.time_pushing.seconds(),d.time_pushing_cpu,
+               d.time_pushing.nanos ? 100.0*d.time_pushing_cpu/(d.time_pushing.seconds()*workers->size()) : 0.0);
+      else
+        fprintf(output,"\t%fs spent pushing.\n",d.time_pushing.seconds());
+      if (cfg.postprocess && !between_phases) 
+        fprintf(output,"\t%fs spent postprocessing the plan.\n",d.time_postprocessing.seconds());                
+      
+      fprintf(output,"\nExtend latency per layer (calls per bucket, headed by its upper bound):\n");
+      printHistograms(output,d.extend_latency);
     }
 
-    printf("\n"); fflush(stdout);        
+    fprintf(output,"\n"); fflush(output);        
+  }
+  
+#ifdef PDR_TRACE
+  // the event of the current phase, unless already written
+  void traceEndOfPhase() {
+    if (trace && trace_phase_start)
+      trace->complete("phase","phase",portfolio_idx,trace_phase_start,nowNanos(),"\"phase\":%zu",phase);
+    trace_phase_start = 0;
+  }
+#endif
+  
+  // appends to a record being built, printf-like
+  static void appendf(string& out, const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args,fmt);
+    vsnprintf(buf,sizeof(buf),fmt,args);
+    va_end(args);
+    out += buf;
+  }
+  
+  /*
+   one line to stats_stream: a JSON object with the counts since the previous record and the current state of the layers and memory
+   the whole line is written by a single call, so that the members of a portfolio can share the stream
+  */
+  void recordStats(bool final) {
+    SearchStats d = stats.since(stats_recorded);
+    stats_recorded = stats;
+    
+    string rec;
+    appendf(rec,"{");
+    if (portfolio)
+      appendf(rec,"\"member\":%d,",portfolio_idx);
+    appendf(rec,"\"phase\":%zu,\"final\":%s,",phase,final ? "true" : "false");
+    
+    appendf(rec,"\"obligations\":{\"processed\":%zu,\"extended\":%zu,\"sidestepped\":%zu,\"blocked\":%zu,\"subsumed\":%zu,\"killed\":%zu,",
+      d.oblig_processed,d.oblig_sat,d.oblig_side,d.oblig_unsat,d.oblig_subsumed,d.oblig_killed);
+    appendf(rec,"\"alive\":%zu,\"stored\":%zu,\"grave\":%zu},",obl_alive,obl_stored,obl_grave.size());
+    
+    appendf(rec,"\"clauses\":{\"derived\":%zu,\"subsumed\":%zu,\"pushed\":%zu,\"shared\":%zu,\"imported\":%zu,\"rejected\":%zu},",
+      d.cla_derived,d.cla_subsumed,d.cla_pushed,d.cla_exported,d.cla_imported,d.cla_rejected);
+    appendf(rec,"\"minimization\":{\"attempted\":%zu,\"removed\":%zu},",d.minim_attempted,d.minim_litkilled);
+    
+    appendf(rec,"\"layers\":[");
+    for (size_t i = 0; i < layers_delta.size(); i++) {
+      size_t lensum = 0;
+      for (size_t j = 0; j < layers_delta[i].size(); j++)
+        lensum += layers_delta[i][j]->num_lits;
+      pruneInvalid(layers_deriv[i],i);
+      
+      appendf(rec,"%s{\"delta\":%zu,\"deriv\":%zu,\"avg_len\":",i ? "," : "",layers_delta[i].size(),layers_deriv[i].size());
+      if (layers_delta[i].size())
+        appendf(rec,"%.3f}",lensum*(1.0/layers_delta[i].size()));
+      else
+        appendf(rec,"null}");
+    }
+    appendf(rec,"],");
+    
+    appendf(rec,"\"time\":{\"extend_sat\":%.6f,\"extend_side\":%.6f,\"extend_uns\":%.6f,\"minimizing\":%.6f,\"subsumption\":%.6f,",
+      d.time_extend_sat.seconds(),d.time_extend_side.seconds(),d.time_extend_uns.seconds(),d.time_minimizing.seconds(),d.time_subsumption.seconds());
+    appendf(rec,"\"pushing\":%.6f,\"pushing_cpu\":%.6f,\"postprocessing\":%.6f},",
+      d.time_pushing.seconds(),d.time_pushing_cpu,d.time_postprocessing.seconds());
+    
+    appendf(rec,"\"extend_latency\":[");
+    for (size_t i = 0; i < d.extend_latency.size(); i++) {
+      appendf(rec,"%s[",i ? "," : "");
+      for (size_t b = 0; b < TimeStat::NUM_BUCKETS; b++)
+        appendf(rec,"%s%zu",b ? "," : "",d.extend_latency[i].buckets[b]);
+      appendf(rec,"]");
+    }
+    appendf(rec,"],");
+    
+    struct rusage usage;
+    getrusage(RUSAGE_SELF,&usage);
+    appendf(rec,"\"memory\":{\"obligations_kb\":%zu,\"clauses_kb\":%zu,\"peak_rss_kb\":%ld}}\n",
+      obligation_pool.bytesInUse()/1024,clause_pool.bytesInUse()/1024,usage.ru_maxrss);
+    
+    fputs(rec.c_str(),stats_stream);
+    fflush(stats_stream);
   }
   
   void printLayers() {
     for (size_t i = 0; i < layers_delta.size(); i++) {            
-      printf("Layer %zu:\n",i);
+      fprintf(output,"Layer %zu:\n",i);
       for (size_t j = 0; j < layers_delta[i].size(); j++)          
-        printClauseNice(layers_delta[i][j]->data);
+        printClauseNice(layers_delta[i][j]->lits());
     } 
   }
   
@@ -377,84 +916,264 @@ struct SolvingContext {
     */
     /*
     for (size_t i = 0; i < layers_delta.size(); i++) {
-      printf("Layer %zu:\n",i);
+      fprintf(output,"Layer %zu:\n",i);
       for (size_t j = 0; j < layers_delta[i].size(); j++)          
-        printClauseNice(layers_delta[i][j]->data);
+        printClauseNice(layers_delta[i][j]->lits());
     
       if (i > 0)
         for (size_t j = 0; j < layers_delta[i].size(); j++) {
           bool found = false;
           for (size_t k = 0; k < layers_delta[i-1].size(); k++) 
-            if (subsumes(layers_delta[i-1][k]->data,layers_delta[i][j]->data)) {
+            if (subsumes(layers_delta[i-1][k]->lits(),layers_delta[i][j]->lits())) {
               found = true;
               break;
             }
           if (!found) {        
-            printf("In layer %zu, following clause not subsumed in prev layer: ",i); printClauseNice(layers_delta[i][j]->data);
+            fprintf(output,"In layer %zu, following clause not subsumed in prev layer: ",i); printClauseNice(layers_delta[i][j]->lits());
           }
         }        
     }  
     */
     
+#ifdef PDR_TRACE
+    traceEndOfPhase();
+#endif
+    
     if (phase > 0) {
-      printf("\nGame over during phase %zu\n",phase);      
+      fprintf(output,"\nGame over during phase %zu\n",phase);      
       printStat(false);
+      
+      if (stats_stream)
+        recordStats(true);
     }
     
+    fprintf(output,"\nRandom seed: %u%s\n",rng_seed,replaying ? " (replayed)" : "");
+    
     { // Global timing 
       times( &gend );
-      printf("\nPDR took: %7.2f seconds overall.\n\n",( float ) ( ( gend.tms_utime - gstart.tms_utime + gend.tms_stime - gstart.tms_stime  ) / 100.0 ));                           
+      fprintf(output,"\nPDR took: %7.2f seconds overall.\n",( float ) ( ( gend.tms_utime - gstart.tms_utime + gend.tms_stime - gstart.tms_stime  ) / 100.0 ));                           
+      
+      struct rusage usage;
+      getrusage(RUSAGE_SELF,&usage);
+      fprintf(output,"Peak memory: %ld KB.\n\n",usage.ru_maxrss);
     }    
   }   
   
+  void seedRandom(unsigned seed) {
+    rng_seed = rng_state = seed;
+  }
+  
+  /*
+   opens the replay log, either to record the random numbers of this run or to take them from an earlier one
+   the header identifies the run (seed and problem size), so that a log is not replayed against another problem
+  */
+  bool openReplayLog(const char* name, bool replay) {
+    replay_log = fopen(name,replay ? "r" : "w");
+    if (!replay_log) {
+      fprintf(output,"Cannot open replay log %s: %s\n",name,strerror(errno));
+      return false;
+    }
+    replaying = replay;
+    
+    if (!replay) {
+      fprintf(replay_log,"seed %u actions %d facts %zu\n",rng_seed,gnum_actions,sigsize);
+      return true;
+    }
+    
+    unsigned seed;
+    int num_actions;
+    size_t num_facts;
+    if (fscanf(replay_log,"seed %u actions %d facts %zu",&seed,&num_actions,&num_facts) != 3) {
+      fprintf(output,"Replay log %s has no valid header.\n",name);
+      return false;
+    }
+    if (num_actions != gnum_actions || num_facts != sigsize) {
+      fprintf(output,"Replay log %s was recorded on a different problem (%d actions, %zu facts).\n",name,num_actions,num_facts);
+      return false;
+    }
+    seedRandom(seed);
+    return true;
+  }
+  
+  int nextRandom() {
+    int r;
+    if (!replaying)
+      r = rand_r(&rng_state);
+    else if (fscanf(replay_log,"%d",&r) != 1) {
+      fprintf(output,"Replay log exhausted, the run has diverged from the recorded one!\n");
+      fflush(output);
+      exit(1);
+    }
+    
+    if (replay_log && !replaying)
+      fprintf(replay_log,"%d\n",r);
+    return r;
+  }
+  
+  // whether another member of the portfolio has already answered (or the portfolio was interrupted)
+  bool stopped() const {
+    return portfolio && (portfolio->interrupted || (portfolio->winner >= 0 && portfolio->winner != portfolio_idx));
+  }
+  
+  // the answer is ours to report, unless another member of the portfolio was first
+  bool claimAnswer() {
+    return !portfolio || __sync_bool_compare_and_swap(&portfolio->winner,-1,portfolio_idx) || portfolio->winner == portfolio_idx;
+  }
+  
   void randomPermutation(vector<size_t> & vec, size_t size) {
     vec.clear();
     for (size_t i = 0; i < size; i++)
       vec.push_back(i);
-               
-    for (size_t i = size-1; i > 0; i--) {
-      size_t idx = rand() % (i+1);
+    randomShuffle(vec);
+  }   
+  
+  void randomShuffle(vector<size_t> & vec) {
+    for (size_t i = vec.size(); i > 1; i--) {
+      size_t idx = nextRandom() % i;
       size_t tmp = vec[idx];
-      vec[idx] = vec[i];
-      vec[i] = tmp;                   
+      vec[idx] = vec[i-1];
+      vec[i-1] = tmp;                   
     } 
-  }   
+  }
+  
+  // a random action order for a new layer
+  void newActionOrder() {
+    action_ords.push_back(vector<size_t>());
+    randomPermutation(action_ords.back(),gnum_actions);
+    
+    action_ord_pos.push_back(vector<size_t>(gnum_actions));
+    for (size_t i = 0; i < (size_t)gnum_actions; i++)
+      action_ord_pos.back()[action_ords.back()[i]] = i;
+  }
   
   bool isLayerState(size_t layer_idx, BoolState const& state) {
     for (size_t i = 0; i < layers_delta[layer_idx].size(); i++)
-      if (clauseUnsatisfied(layers_delta[layer_idx][i]->data,state))
+      if (clauseUnsatisfied(layers_delta[layer_idx][i]->packed(),state))
         return false;
         
     // is this neccessary?
     for (size_t i = 0; i < layers_deriv[layer_idx].size(); i++)
-      if (clauseUnsatisfied(layers_deriv[layer_idx][i]->data,state))
+      if (clauseUnsatisfied(layers_deriv[layer_idx][i]->packed(),state))
         return false;
     
     return true;
   }
   
   // extend temporaries:
-  vector<Action *>     actions; // actions dumped into vector for random access
+  vector<int>          action_scores;      // indexed by action, recorded for the action ordering heuristic in extend
+  vector<char>         action_interesting; // indexed by action, see extend
   
   size_t      used_buffer_size;
   vector<ClauseBuffer> buffers; // for every interesting action a list (in a form of a buffer) of potential contributions to the final clause
   
   vector< vector<size_t> > action_ords; //action order separately for each layer_idx
+  vector< vector<size_t> > action_ord_pos; // the inverse of each: the position of an action in action_ords[layer_idx]
+  
+  // the actions extend tries: only those adding a literal of a false clause, as no other can be plausible, interesting or "side" (in the order of actions_ord)
+  vector<size_t>   extend_cands;
+  vector<char>     cand_action_mark; // indexed by action; all zero between the calls
+  vector<char>     cand_lit_mark;    // likewise by literal
+  vector<size_t>   cand_lits;
+  vector<size_t>   action_ord_rest;  // for reordering actions_ord
   
   vector<size_t>   buffer_ord;  // indices to traverse buffers in specific order
   
-  BoolState false_precond_lits; // false preconditions of the current action
-  BoolState      working_state; // the currently considered potential next state
+  /* temporaries of the action loop of extend, one set per worker thread (see tryAction)
+  
+     the successor of an action is never built from scratch:
+     working_state equals state between the actions, the action's effects are applied to it and undone again at the end of the round
+     
+     false_precond_lits records preconditions of the current action (and is all false between the actions),
+     used to skip reasons from false clauses "subsumed" by a failed precond reason;
+     at the same time such a clause is still considerd false with respect to "side" and its counting */
+  struct ExtendScratch {
+    BoolState false_precond_lits; // false preconditions of the current action
+    BoolState      working_state; // the currently considered potential next state
+    
+    Clause            inv_clause; // temporary storage for current invariant clause
+    
+    // clauses of layers_delta[layer_idx] and layers_deriv[layer_idx], and indices to invariant, of the clauses which lost a true literal by the current action's delete effect
+    Clauses        layer_candidates;
+    vector<size_t> inv_candidates;
+    
+    // for pushTest: its candidate actions and their marks (indexed by action, all zero between the calls)
+    vector<size_t> push_cands;
+    vector<char>   push_mark;
+    
+    // for pushTest: push_state is all true but push_cleared, and so is working_state while push_ready (i.e. since the last pushTest, if no reset came in between)
+    BoolState      push_state;
+    Clause         push_cleared;
+    bool           push_ready;
+    vector<size_t> push_false_clauses;
+    ClauseBuffer   push_buffer;
+    
+    ExtendScratch() : push_ready(false) {}
+    
+    void reset(BoolState const& state) {
+      working_state = state;
+      push_ready = false;
+      if (false_precond_lits.size() != state.size()) { // otherwise all false already (see above)
+        false_precond_lits.resize(state.size());
+        false_precond_lits.fill(false);
+      }
+    }
+  };
+  
+  // what tryAction found out about an action
+  struct ActionOutcome {
+    bool plausible;   // as far as we see it, it could be applied and would yield a good successor (satisfying all the clauses it should)
+    bool interesting; // satisfies at least one false clause -> keep the reason set for it
+    bool side;        // qualifies for "side" (with false_after below the threshold passed to tryAction)
+    int  false_after; // the number of false_clauses false in the successor
+    int  score;       // for action_scores
+  };
+  
+  vector<ExtendScratch> extend_scratch; // [0] for the calling thread, the others for the workers
+  BoolState              working_state; // after the action loop: the union of reasons, i.e. the clause being built and minimized
+  Clause                 union_lits;    // the literals unionReasons set in working_state (the only ones that can be true there), so that it is cleared and traversed in the clause size, not sigsize
   
   vector<size_t>       lit_ord; // for traversing literals of the output clause in a specific order
-  Clause            inv_clause; // temporary storage for current invariant clause
+  
+  // minimizeReason temporaries, see minimBlocked
+  vector<size_t>       minim_reason_pos; // per reason of the used buffers (the ones initially covered): the position of its buffer in buffer_ord
+  vector<size_t>       minim_reason_at;  // per reason: where it starts in the buffer's clauses
+  vector<size_t>       minim_missing;    // per reason: how many of its literals are not in working_state
+  vector<size_t>       minim_lit_pos;    // per literal of union_lits: its position there (garbage for the other literals)
+  vector<size_t>       minim_occ_start;  // per position k in union_lits: the reasons containing the literal are minim_occ[minim_occ_start[k]], ..., minim_occ[minim_occ_start[k+1]-1]
+  vector<size_t>       minim_occ;
+  vector<size_t>       minim_occ_fill;
+  vector<size_t>       minim_covered;    // per position in buffer_ord: how many of the buffer's reasons miss nothing
+  vector<size_t>       minim_adds_in;    // per action: how many of its adds are in working_state (all zero between the calls)
+  vector<size_t>       minim_buffer_pos; // per action: the position of its buffer in buffer_ord, or NO_ACTION (likewise between the calls)
+  size_t               minim_noop_pos;   // the position of the no-op's buffer, or NO_ACTION
+  size_t               minim_noop_adders; // how many non-interesting actions add a literal of working_state
+  size_t               minim_uncovered;  // how many buffers have no reason left
+  size_t               minim_failing;    // how many of those the inductive argument can't excuse
   
   vector<size_t> false_clauses; // indices to layers_delta[layer_idx] pointing to clauses unsat in state
   
+  // parallel extend (-j): the workers split actions_ord among themselves and try each action into its own buffer and outcome (indexed by the position);
+  // these get merged in the order afterwards
+  WorkerPool*            workers;           // 0 if running single threaded
+  vector<ActionOutcome>  action_outcomes;
+  size_t                 job_layer_idx;
+  BoolState const*       job_state;
+  vector<size_t> const*  job_ord;
+  int                    job_side_threshold;
+  size_t                 job_next;             // the next position to be taken by a worker
+  size_t                 job_first_plausible;  // the smallest position of a plausible action found so far
+  static const size_t    JOB_CHUNK = 16;       // positions taken by a worker at once
+  static const size_t    PARALLEL_MIN_ACTIONS = 256; // for fewer actions it does not pay off to wake up the workers
+  
+  // parallel pushing: the push tests of the clauses of layers_delta[job_layer_idx], taken one by one by the workers (job_next)
+  vector<char>           push_results;      // indexed as the layer; 1 if the clause's push test failed, i.e. it stays
+  uint64_t               push_workers_cpu;  // the cpu time of the workers other than the calling thread (which measures itself)
+  
   // extend output:  
-  Action*           extend_action_out;
+  size_t            extend_action_out;
     
   Clause            extend_clause_out;  // may return more than one   
+  PackedClause      extend_packed_out;  // the same, packed (filled by the caller when needed)
   
   vector<int>       reason_histogram;
   static const size_t  histogram_size = 10; 
@@ -465,306 +1184,946 @@ struct SolvingContext {
     CompareBufferSizes(vector<ClauseBuffer> & buffs) : buffers(buffs) {}
   };   
   
+  struct CompareActionPositions {
+    vector<size_t> & positions;
+    bool operator() (size_t i,size_t j) { return (positions[i] < positions[j]); }
+    CompareActionPositions(vector<size_t> & pos) : positions(pos) {}
+  };
+
+  struct CompareLayerPositions {
+    bool operator() (ClauseBox* a,ClauseBox* b) { return (a->layer_pos < b->layer_pos); }
+  };
+
   struct CompareActionScores {
-    vector<Action *> & actions;
-    bool operator() (size_t i,size_t j) { return (actions[i]->score < actions[j]->score); }
-    CompareActionScores(vector<Action *> & acts) : actions(acts) {}
+    vector<int> & scores;
+    bool operator() (size_t i,size_t j) { return (scores[i] < scores[j]); }
+    CompareActionScores(vector<int> & scs) : scores(scs) {}
   };
   
-  char extend(size_t layer_idx, BoolState const & state, bool pushTest, bool chat = false) {           
-    // will be set to a non-null action before returning result > 0  
-    extend_action_out = NULL;
-            
-    //printf("Extend into %zu:\n",layer_idx);
-    //printState(state);    
+  /*
+   tries action a from state (one round of the action loop of extend): whether it is plausible and good for "side" and, if it is not, records the reasons into buffer
+   false_clauses are the clauses of layers_delta[layer_idx] false in state (as in extend)
+   scratch must be reset to state; it is left so again
+   nothing but buffer and scratch is written, so different actions (and different states) can be tried in parallel
+  */
+  ActionOutcome tryAction(ExtendScratch & scratch, size_t layer_idx, BoolState const & state, vector<size_t> const & false_clauses, bool pushTest, size_t a, ClauseBuffer & buffer, int side_threshold) {
+    ActionOutcome outcome = { false, false, false, 0, 0 };
     
-    /*
-     false clauses are those which the current state doesn't satisfy
-     it is typically much smaller set than the whole layers_delta[layer_idx]
-     
-     it pays off to focus on false clauses first
-     > for the positive case, we only look at the other clauses (which the action could have made false due to a delete effect)
-       when the action looks plausible (all precondintions are true in current and all false_clauses true in the successor)
-     > for the negative case (if the default quickreason is on) only plausible actions seek reasons
-       among the other clauses
-       
-     the "side" trick (the default resched = 2) returns an action as if it was a proper successor if it satisfies some false_clauses and does not undo validity any other clause
-    */
-    false_clauses.clear();
-    for (size_t i = 0; i < layers_delta[layer_idx].size(); i++)
-      if (clauseUnsatisfied(layers_delta[layer_idx][i]->data,state)) {
-        // printf("False clause %zu: ",false_clauses.size()); printClauseNice(layers_delta[layer_idx][i]->data);
-        false_clauses.push_back(i);
-      }
+    BoolState & working_state = scratch.working_state;
+    BoolState & false_precond_lits = scratch.false_precond_lits;
+    Clause & inv_clause = scratch.inv_clause;
+    Clauses & layer_candidates = scratch.layer_candidates;
+    vector<size_t> & inv_candidates = scratch.inv_candidates;
     
-    // printf("Extending state into %zu; number of false clauses %zu\n",layer_idx,false_clauses.size());    
-    // printf("The state:\n"); printStateHash(state);
+    size_t layers_delta_size = layers_delta[layer_idx].size();
+    size_t layers_deriv_size = layers_deriv[layer_idx].size();
+    size_t layers_size       = layers_delta_size + layers_deriv_size;
     
-    assert(false_clauses.size() > 0); // there is always a false clause, otherwise <state> could already sit in layer_idx-th layer
-    // moreover, there is never a false clause from layers_deriv nor in invariant (that has been already checked "above")
+    bool plausible = true;         // as far as we see it, it could be applied and would yield a good successor (satisfying all the clauses it should)
+    bool interesting = false;      // satisfies at least one false clause -> keep the reason set for it
     
-    // for implementing "side"
-    Action *best_action = 0;
-    int best_false_after = (int)false_clauses.size(); // must improve to qualify    
+    // for "side"
+    bool failed_precond = false;   // know explicitly whether a side condition failed
+    int false_after = 0;           // count the number of false_clauses false in the successor      
+    bool can_do_side;              
+    bool just_because_side;        
     
-    // records preconditions of the current action 
-    // used to skip reasons from false clauses "subsumed" by a failed precond reason
-    // at the same time such a clause is still considerd false with respect to "side" and its counting
-    false_precond_lits.clear();
-    false_precond_lits.resize(state.size(),false);    
+    buffer.clear();
+    buffer.action = a;
+
+    // printf("--- Trying action %zu:",act_idx); printAction(stdout,a);      
     
-    // for recording reasons of "interesting" actions
-    // interesting action is an action the reason set of which is not "SUBSUMED" by the reason set of NOOP (e.g. it must make at least one false_clase true)
-    // we don't need to record reasons of non-interesting actions (this tends to speedup subsequent overall-reason computation and minimization)
-    used_buffer_size = 0;
-    
-    assert(layer_idx < action_ords.size());    
-    vector<size_t> & actions_ord = action_ords[layer_idx];    
-
-    for (size_t act_idx = 0; act_idx < actions_ord.size(); act_idx++) {
-      size_t action_idx = actions_ord[act_idx];
-      Action *a = actions[action_idx];
-      
-      bool plausible = true;         // as far as we see it, it could be applied and would yield a good successor (satisfying all the clauses it should)
-      bool interesting = false;      // satisfies at least one false clause -> keep the reason set for it
-      a->interesting = 0;
-      
-      // for "side"
-      bool failed_precond = false;   // know explicitly whether a side condition failed
-      int false_after = 0;           // count the number of false_clauses false in the successor      
-      bool can_do_side;              
-      bool just_because_side;        
-      
-      // give me a buffer for the current action
-      ClauseBuffer & buffer = buffers[used_buffer_size++];
-      buffer.clear();
-      buffer.action = a;
-
-      // printf("--- Trying action %zu:",act_idx); printAction(stdout,a);      
+    // adding 
+    bool useless = true;
+    for (int i = 0; i < numAdds(a); i++) {
+      int add = getAdd(a,i);
       
-      // start preparing the successor state
-      working_state.clear();
-      for (size_t i = 0; i < state.size(); i++)
-        working_state.push_back(state[i]);      
-            
-      // adding 
-      bool useless = true;
-      for (int i = 0; i < numAdds(a); i++) {
-        int add = getAdd(a,i);
-        working_state[add] = true;
-        
-        if (!state[add])
-          useless = false;
+      if (!state[add]) {
+        working_state.set(add);
+        useless = false;
       }
+    }
+    
+    // useless action cannot help reaching the goal from here
+    if (useless) {
+      outcome.score = INT_MAX; // syst2 had "(int)false_clauses.size();" here instead (not to discriminate the "here useless" too much), but it wasn't that successful
+      return outcome;          // (and working_state has not been touched)
+    }
+                
+    // test preconditions
+    size_t failed_preconds = 0;
+    for (int i = 0; i < numPreconds(a); i++) {
+      int precond = getPrecond(a,i);
+      if (!state[precond]) {
+        
+        //printf("Failed precond: ");
+        //print_ft_name(precond); 
+        //printf("\n");          
       
-      // useless action cannot help reaching the goal from here
-      if (useless) {
-        used_buffer_size--; // the current buffer will get overwritten in the next round         
-        a->score = INT_MAX; // syst2 had "(int)false_clauses.size();" here instead (not to discriminate the "here useless" too much), but it wasn't that successful
-        continue;
-      }
-                  
-      // test preconditions
-      size_t failed_preconds = 0;
-      for (int i = 0; i < numPreconds(a); i++) {
-        int precond = getPrecond(a,i);
-        if (!state[precond]) {
+        if (pushTest)
+          goto next_action_1;
           
-          //printf("Failed precond: ");
-          //print_ft_name(precond); 
-          //printf("\n");          
+        plausible = false;
+        failed_precond = true;
         
-          if (pushTest)
-            goto next_action_1;
-            
-          plausible = false;
-          failed_precond = true;
-          
-          // record the reason
-          buffer.num_clauses++;
-          buffer.clauses.push_back(1);
-          buffer.clauses.push_back(precond);
-                              
-          failed_preconds++;
-          
-          false_precond_lits[precond] = true;
+        // record the reason
+        buffer.num_clauses++;
+        buffer.clauses.push_back(1);
+        buffer.clauses.push_back(precond);
+                            
+        failed_preconds++;
+        
+        false_precond_lits.set(precond);
+      }
+    }
+    // if (chat) printf("%zuF  ",failed_preconds);
+                         
+    // deleting
+    for (int i = 0; i < numDels(a); i++) {
+      int del = getDel(a,i);
+      working_state.reset(del);
+    }                 
+    
+    { // first check the false clauses
+      size_t failed_cnt = 0;
+    
+      for (size_t i = 0; i < false_clauses.size(); i++) {
+        ClauseBox *clbox = layers_delta[layer_idx][false_clauses[i]];
+        ClauseView cl = clbox->lits();
+        
+        if (!clauseUnsatisfied(clbox->packed(),working_state))
+          continue;
+        
+        failed_cnt++;
+ 
+        //printf("Failed false clause %zu\n",i);
+        if (pushTest)
+          goto next_action_1;
+ 
+        if (!clauseUnsatisfied(clbox->packed(),false_precond_lits)) { // a better reason has been recorded already
+          assert(!plausible);
+          continue;
         }
+        
+        // we have a false clause 
+        plausible = false;          
+        false_after++;
+        
+        // all literals get recorded          
+        buffer.num_clauses++;                      
+        buffer.clauses.push_back(cl.size());  
+        for (size_t j = 0; j < cl.size(); j++)
+          buffer.clauses.push_back(cl[j]);        
       }
-      // if (chat) printf("%zuF  ",failed_preconds);
-                           
-      // deleting
-      for (int i = 0; i < numDels(a); i++) {
-        int del = getDel(a,i);
-        working_state[del] = false;
-      }                 
-      
-      { // first check the false clauses
-        size_t failed_cnt = 0;
-      
-        for (size_t i = 0; i < false_clauses.size(); i++) {
-          Clause &cl = layers_delta[layer_idx][false_clauses[i]]->data;
+
+      if (failed_cnt < false_clauses.size()) {          
+        interesting = true;
+        //printf("Interesting action: "); printAction(stdout,a);
+      } // otherwise the reasons are boring; effectively subsumed by those of NOOP
+    }
+    
+    if (plausible)
+      outcome.score = INT_MAX; // if we ever get to use the score, it will mean this action breaks something below and so can never be used successfully in this context
+    else
+      outcome.score = (int)buffer.num_clauses;
+         
+    can_do_side = (cfg.resched == 2) && !failed_precond && (false_after < side_threshold);
+    just_because_side = false;            
           
-          if (!clauseUnsatisfied(cl,working_state))
+    if ( plausible ||                                         // normally, only if the action still seems ok, we perform the full test
+        (cfg.quick_reason == 0) ||                      // unless we don't want the quickreason trick (seems to harm on UNSAT problems)
+        (interesting && cfg.quick_reason == 2) ||       // something in the middle (experimental)
+        (just_because_side = true, can_do_side) ) {           // or if we still need to check whether "side" is an option ...
+        
+      /*
+       apart from false_clauses (which had their turn already), only the clauses which lost a true literal by a delete effect can be unsat in the successor;
+       a clause is collected only via the first of its literals that got deleted
+       
+       a push test gives up on the first unsat clause and its state may falsify layer and invariant clauses on its own, so there we simply scan everything;
+       we also scan the layers whenever the occurrence lists (which mix all the layers) are longer than the current layer itself
+       (long clauses over a small signature), since checking a box from the index is more expensive than a sequential check of a packed clause
+      */
+      bool scan_layers = pushTest;
+      if (!pushTest) {
+        size_t occs_total = 0;
+        for (int i = 0; i < numDels(a); i++)
+          if (state[getDel(a,i)])
+            occs_total += clause_index[getDel(a,i)].size();
+        scan_layers = (occs_total > layers_size);
+        
+        layer_candidates.clear();
+        inv_candidates.clear();
+        for (int i = 0; i < numDels(a); i++) {
+          int del = getDel(a,i);
+          if (!state[del])
             continue;
+        
+          for (size_t j = invariant.occBegin(del); j < invariant.occEnd(del); j++) {
+            size_t inv_idx = invariant.occClause(j);
+            invariant.loadClause(inv_idx,inv_clause);
+            if (inv_clause[0] == (size_t)del || !state[inv_clause[0]] || working_state[inv_clause[0]])
+              inv_candidates.push_back(inv_idx);
+          }
           
-          failed_cnt++;
- 
-          //printf("Failed false clause %zu\n",i);
-          if (pushTest)
-            goto next_action_1;
- 
-          if (!clauseUnsatisfied(cl,false_precond_lits)) { // a better reason has been recorded already
-            assert(!plausible);
+          if (scan_layers)
             continue;
-          }
           
-          // we have a false clause 
-          plausible = false;          
-          false_after++;
+          Clauses &occs = clause_index[del];
+          for (size_t j = 0; j < occs.size(); ) {
+            ClauseBox *clbox = occs[j++];
+            if (ClauseIndex::isDead(clbox) || !clbox->validAt(layer_idx)) // (dead boxes are not dropped here, the lists are shared by the workers)
+              continue;
+            
+            size_t first_deleted = 0;
+            while (!state[clbox->lits()[first_deleted]] || working_state[clbox->lits()[first_deleted]])
+              first_deleted++;
+            if (clbox->lits()[first_deleted] == (size_t)del)
+              layer_candidates.push_back(clbox);
+          }
+        }
+        sort(layer_candidates.begin(),layer_candidates.end(),CompareLayerPositions()); // the layer order (as when scanning), for the sake of reason recording
+        sort(inv_candidates.begin(),inv_candidates.end()); // the original order, for the sake of reason recording
+      }
+      size_t num_layer_candidates = scan_layers ? layers_size : layer_candidates.size();
+      size_t num_inv_candidates = pushTest ? invariant.size() : inv_candidates.size();
+      
+      size_t false_clause_idx = 0;
+                     
+      for (size_t i = 0; i < num_layer_candidates + num_inv_candidates; i++) {
+        ClauseView cl;
+        if (i < num_layer_candidates) {
+          ClauseBox *clbox;
+          if (!scan_layers)
+            clbox = layer_candidates[i];
+          else if (i < layers_delta_size) {
+            if (false_clause_idx < false_clauses.size() && i == false_clauses[false_clause_idx]) {
+              false_clause_idx++;
+              continue; // we had this one already
+            }
+            clbox = layers_delta[layer_idx][i];
+          } else
+            clbox = layers_deriv[layer_idx][i-layers_delta_size];
           
-          // all literals get recorded          
-          buffer.num_clauses++;                      
-          buffer.clauses.push_back(cl.size());  
+          if (!clauseUnsatisfied(clbox->packed(),working_state))
+            continue; // next clause
+          cl = clbox->lits();
+        } else {
+          size_t inv_idx = pushTest ? i - num_layer_candidates : inv_candidates[i - num_layer_candidates];
+          if (!invariant.clauseUnsatisfied(inv_idx,working_state))
+            continue; // next clause
+          invariant.loadClause(inv_idx,inv_clause);
+          cl = inv_clause;
+        }
+        
+        can_do_side = false;
+        if (just_because_side)
+          break;
+   
+        //printf("Failed clause: "); printClauseNice(cl);
+        if (pushTest)
+          goto next_action_1;
+
+        if (!clauseUnsatisfied(cl,false_precond_lits)) { // a better reason has been recorded already
+          assert(!plausible);
+          continue;
+        }
+        
+        // we have a false clause 
+        plausible = false;
+        
+        // all preserved negative literals get recorded
+        {
+          buffer.num_clauses++;
+          size_t new_cl_size = 0;
+          size_t new_cl_idx = buffer.clauses.size();
+          buffer.clauses.push_back(0);  // will update when we know the real size
           for (size_t j = 0; j < cl.size(); j++)
-            buffer.clauses.push_back(cl[j]);        
+            if (!state[cl[j]]) { // was already false, so was preserved; the others were deleted explicitly so cannot be part of the reason clause
+              new_cl_size++;
+              buffer.clauses.push_back(cl[j]);
+              
+              //print_ft_name(cl[j]); printf(" ");
+            }
+          buffer.clauses[new_cl_idx] = new_cl_size; 
         }
 
-        if (failed_cnt < false_clauses.size()) {          
-          interesting = true;
-          a->interesting = 1;
-          //printf("Interesting action: "); printAction(stdout,a);
-        } else {
-          used_buffer_size--; // the current buffer will get overwritten in the next round (the reasons are boring; effectively subsumed by those of NOOP)                    
+        //printf("\n");                   
+      }
+      
+      //if (chat) printf(" R: %zu\n",buffer.num_clauses);
+    }   
+    
+    outcome.plausible = plausible;
+    outcome.interesting = interesting;
+    outcome.false_after = false_after;
+    
+    // all clauses sat in new state
+    if (plausible)
+      goto next_action_1;
+                
+    if (can_do_side &&
+       isLayerState(layer_idx+1,working_state)) { /* since layers_deriv are sumbsumption reduced, 
+                                                  there is still a risk the successors does not satisfy all the layer clauses of its parent */                             
+      // printStateHash(working_state);      
+      outcome.side = true;
+    }
+    
+    next_action_1: 
+    // cleanup for the action
+    for (int i = 0; i < numPreconds(a); i++) 
+      false_precond_lits.reset(getPrecond(a,i));
+    
+    // turn working_state back into state (a del effect may not have been applied yet, but then it is a no-op)
+    for (int i = 0; i < numAdds(a); i++)
+      if (!state[getAdd(a,i)])
+        working_state.reset(getAdd(a,i));
+    for (int i = 0; i < numDels(a); i++)
+      if (state[getDel(a,i)])
+        working_state.set(getDel(a,i));
+    
+    return outcome;
+  }
+  
+  static void extendJob(void* context, size_t worker) {
+    ((SolvingContext*)context)->extendWorker(worker);
+  }
+  
+  // a worker's share of parallel extend: takes chunks of positions of job_ord until they run out or lie behind a plausible action
+  void extendWorker(size_t worker) {
+    ExtendScratch & scratch = extend_scratch[worker];
+    scratch.reset(*job_state);
+    
+    vector<size_t> const & actions_ord = *job_ord;
+    for (;;) {
+      size_t begin = __sync_fetch_and_add(&job_next,JOB_CHUNK);
+      size_t end = min(begin+JOB_CHUNK,actions_ord.size());
+      
+      for (size_t act_idx = begin; act_idx < end; act_idx++) {
+        if (act_idx > *(volatile size_t*)&job_first_plausible) // may be outdated, but only ever decreases
+          return;
+          
+        ActionOutcome & outcome = action_outcomes[act_idx];
+        outcome = tryAction(scratch,job_layer_idx,*job_state,false_clauses,false,actions_ord[act_idx],buffers[act_idx],job_side_threshold);
+        
+        if (outcome.plausible) {
+          size_t cur;
+          while (act_idx < (cur = *(volatile size_t*)&job_first_plausible) && 
+                 !__sync_bool_compare_and_swap(&job_first_plausible,cur,act_idx))
+            ;
+          return;
         }
       }
       
-      if (plausible)
-        a->score = INT_MAX; // if we ever get to use the score, it will mean this action breaks something below and so can never be used successfully in this context
+      if (end == actions_ord.size())
+        return;
+    }
+  }
+  
+  /*
+   whether the clause can be pushed from layer_idx to the next layer, i.e. no action leads from the weakest state falsifying it into layer_idx
+   (the same check as extend would do for that state, but giving up on the first failed clause and not touching any shared data; layers_deriv[layer_idx] must be pruned)
+   a clause that doesn't exclude the weakest state from layers_delta[layer_idx] itself fails as well (only possible for a clause from elsewhere)
+  */
+  bool pushTest(ExtendScratch & scratch, size_t layer_idx, ClauseView cl) {
+    BoolState & push_state = scratch.push_state;
+    BoolState & working_state = scratch.working_state;
+    Clause & push_cleared = scratch.push_cleared;
+    if (!scratch.push_ready) {
+      if (push_state.size() != sigsize) {
+        push_state.resize(sigsize);
+        push_state.fill(true);
+        push_cleared.clear();
+      }
+      scratch.reset(push_state);
+      scratch.push_ready = true;
+    }
+    
+    // from the weakest state of the previous clause to that of cl, touching just the literals of the two
+    for (size_t n = 0; n < push_cleared.size(); n++) {
+      push_state.set(push_cleared[n]);
+      working_state.set(push_cleared[n]);
+    }
+    push_cleared.clear();
+    for (size_t n = 0; n < cl.size(); n++) {
+      push_state.reset(cl[n]);
+      working_state.reset(cl[n]);
+      push_cleared.push_back(cl[n]);
+    }
+      
+    vector<size_t> & push_false_clauses = scratch.push_false_clauses;
+    push_false_clauses.clear();
+    for (size_t i = 0; i < layers_delta[layer_idx].size(); i++)
+      if (clauseUnsatisfied(layers_delta[layer_idx][i]->packed(),push_state))
+        push_false_clauses.push_back(i);
+    if (push_false_clauses.empty())
+      return false;
+    
+    // a plausible action has to add a literal of every false clause, so it is enough to try the adders of one (the one with the fewest);
+    // which one answers first doesn't matter here
+    size_t best_clause = 0, best_adders = (size_t)-1;
+    for (size_t i = 0; i < push_false_clauses.size(); i++) {
+      ClauseView fcl = layers_delta[layer_idx][push_false_clauses[i]]->lits();
+      size_t adders = 0;
+      for (size_t n = 0; n < fcl.size(); n++)
+        adders += numAdders(fcl[n]);
+      if (adders < best_adders) {
+        best_adders = adders;
+        best_clause = push_false_clauses[i];
+      }
+    }
+    
+    vector<size_t> & push_cands = scratch.push_cands;
+    vector<char> & push_mark = scratch.push_mark;
+    push_mark.resize(gnum_actions,0);
+    push_cands.clear();
+    ClauseView fcl = layers_delta[layer_idx][best_clause]->lits();
+    for (size_t n = 0; n < fcl.size(); n++)
+      for (size_t i = 0; i < numAdders(fcl[n]); i++) {
+        size_t a = getAdder(fcl[n],i);
+        if (!push_mark[a]) {
+          push_mark[a] = 1;
+          push_cands.push_back(a);
+        }
+      }
+    for (size_t i = 0; i < push_cands.size(); i++)
+      push_mark[push_cands[i]] = 0;
+    
+    for (size_t i = 0; i < push_cands.size(); i++)
+      if (tryAction(scratch,layer_idx,push_state,push_false_clauses,true,push_cands[i],scratch.push_buffer,0).plausible)
+        return false; // SAT -> not pushed
+        
+    return true;
+  }
+  
+  static void pushJob(void* context, size_t worker) {
+    ((SolvingContext*)context)->pushWorker(worker);
+  }
+  
+  void pushWorker(size_t worker) {
+    ExtendScratch & scratch = extend_scratch[worker];
+    Clauses & layer = layers_delta[job_layer_idx];
+    uint64_t cpu_start = threadCpuNanos();
+    
+    for (;;) {
+      size_t i = __sync_fetch_and_add(&job_next,1);
+      if (i >= layer.size())
+        break;
+      push_results[i] = !pushTest(scratch,job_layer_idx,layer[i]->lits());
+    }
+    
+    if (worker)
+      __sync_fetch_and_add(&push_workers_cpu,threadCpuNanos() - cpu_start);
+  }
+  
+  // the conflict clause as the union of one reason per used buffer (the one adding the fewest new literals), into working_state
+  void unionReasons() {
+    // prepare the conflict clause -- abusing the workingstate for that (to represent the union being built)
+    if (working_state.size() != sigsize) {
+      working_state.resize(sigsize);
+      working_state.fill(false);
+    } else
+      for (size_t i = 0; i < union_lits.size(); i++)
+        working_state.reset(union_lits[i]);
+    union_lits.clear();
+    
+    // resize buffer ord and sort it based on buffer sizes
+    randomPermutation(buffer_ord,used_buffer_size);   // TODO: could skip the random and use identity permutation instead (no big deal, would it speed up?)
+    sort(buffer_ord.begin(),buffer_ord.end(),CompareBufferSizes(buffers)); //start with small buffers            
+    
+    for (size_t act_idx = 0; act_idx < buffer_ord.size(); act_idx++) {
+      ClauseBuffer & buffer = buffers[buffer_ord[act_idx]];      
+      assert(buffer.num_clauses > 0);      
+      
+      /*
+      fprintf(output,"%zu contributions of action %zu: ",buffer.num_clauses,buffer_ord[act_idx]);
+      if (buffer.action != NO_ACTION)
+        printAction(output,buffer.action);
       else
-        a->score = (int)buffer.num_clauses;
-           
-      can_do_side = (gcmd_line.resched == 2) && !failed_precond && (false_after < best_false_after);
-      just_because_side = false;            
-            
-      if ( plausible ||                                         // normally, only if the action still seems ok, we perform the full test
-          (gcmd_line.quick_reason == 0) ||                      // unless we don't want the quickreason trick (seems to harm on UNSAT problems)
-          (interesting && gcmd_line.quick_reason == 2) ||       // something in the middle (experimental)
-          (just_because_side = true, can_do_side) ) {           // or if we still need to check whether "side" is an option ...
+        fprintf(output,"(NOOP)\n");
+      */
+      
+      size_t best_adds = sigsize+1;
+      size_t best_idx = 0;
+      
+      size_t i = 0;
+      size_t sz = 0;
+      while (i < buffer.clauses.size()) {
+        sz = buffer.clauses[i];
+        
+        size_t curbase = i;
+        size_t curadds = 0;
+        
+        while (i++,sz--) {
+          /*
+          print_ft_name(buffer.clauses[i]);
+          fprintf(output," ");          
+          */
           
-        pruneInvalid(layers_deriv[layer_idx],layer_idx);
-        
-        size_t layers_delta_size = layers_delta[layer_idx].size();
-        size_t layers_deriv_size = layers_deriv[layer_idx].size();
-        size_t invariant_size    = invariant.size();
-        size_t false_clause_idx  = 0;
-                       
-        for (size_t i = 0; i < layers_delta_size + layers_deriv_size + invariant_size; i++) {
-          // bool in_delta = false;
-          // bool in_deriv = false;
-          // bool in_inv   = false;
-        
-          Clause* p_cl;
-          if (i < layers_delta_size) {
-            // TODO: testing whether the test shouldn't be rather skipped
-            if (false_clause_idx < false_clauses.size() && i == false_clauses[false_clause_idx]) {
-              false_clause_idx++;
-              continue; // we had this one already
-            }
-            p_cl = &layers_delta[layer_idx][i]->data;
-            // in_delta = true;
-          } else if (i - layers_delta_size < layers_deriv_size) {
-            p_cl = &layers_deriv[layer_idx][i-layers_delta_size]->data;
-            // in_deriv = true;
-          } else {
-            invariant.loadClause(i - layers_delta_size - layers_deriv_size,inv_clause);
-            p_cl = &inv_clause;
-            // in_inv = true;
+          if (!working_state[buffer.clauses[i]])
+            curadds++;
+        }
+        /*
+        fprintf(output,"\n");        
+        */
+        if (curadds < best_adds) {
+          best_adds = curadds;
+          best_idx = curbase;
+        }        
+        
+        if (best_adds == 0) // no further improvement possible
+          break;
+      }
+      
+      assert(best_adds <= sigsize);
+      // if (chat) printf("- best adds %zu\n",best_adds);
+        
+      // apply the best guy
+      {
+        i = best_idx;
+        sz = buffer.clauses[i];
+        while (i++,sz--)
+          if (!working_state[buffer.clauses[i]]) {
+            working_state.set(buffer.clauses[i]);
+            union_lits.push_back(buffer.clauses[i]);
           }
-          Clause &cl = *p_cl;
+      }
+    }
+  }
 
-          if (!clauseUnsatisfied(cl,working_state))
-            continue; // next clause
-          
-          can_do_side = false;
-          if (just_because_side)
-            break;
+  /* the bookkeeping of minimizeReason: every reason of the used buffers counts its literals missing from working_state,
+     every buffer counts its reasons missing nothing (is "covered" if there is one),
+     so that removing or putting back a literal only touches the reasons containing it (found via the occurrence lists);
      
-          //printf("Failed clause: "); printClauseNice(cl);
-          if (pushTest)
-            goto next_action_1;
-
-          if (!clauseUnsatisfied(cl,false_precond_lits)) { // a better reason has been recorded already
-            assert(!plausible);
-            continue;
+     with cfg.minimize > 1 the inductive argument may excuse an uncovered buffer as long as some goal literal remains in the clause:
+     it applies if the buffer's action adds no literal of the clause (for the no-op, which stands for all the non-interesting actions, if none of them does);
+     for that every action counts its adds in working_state (via the adder index) */
+  bool minimBlocked(size_t pos) {
+    size_t a = buffers[buffer_ord[pos]].action;
+    return (a == NO_ACTION) ? (minim_noop_adders > 0) : (minim_adds_in[a] > 0);
+  }
+  
+  // action a stopped (blocked == false) or started adding a literal of working_state
+  void minimActionChanged(size_t a, bool blocked) {
+    size_t delta = blocked ? 1 : (size_t)-1; // of minim_failing for every uncovered buffer the action stands for
+    if (!action_interesting[a]) {
+      if (blocked ? minim_noop_adders++ == 0 : --minim_noop_adders == 0)
+        if (minim_noop_pos != NO_ACTION && !minim_covered[minim_noop_pos])
+          minim_failing += delta;
+    }
+    size_t pos = minim_buffer_pos[a];
+    if (pos != NO_ACTION && !minim_covered[pos])
+      minim_failing += delta;
+  }
+  
+  /* a read-only look before minimRemove: true if some buffer's only covered reason contains lit 
+     and the buffer surely can't be excused (excusable: goal literals would remain and cfg.minimize > 1);
+     just quickly rejects the common case, false means the full update has to decide */
+  bool minimSurelyKept(size_t lit, bool excusable) {
+    size_t k = minim_lit_pos[lit];
+    for (size_t j = minim_occ_start[k]; j < minim_occ_start[k+1]; j++) {
+      size_t r = minim_occ[j];
+      if (minim_missing[r])
+        continue;
+      size_t pos = minim_reason_pos[r];
+      if (minim_covered[pos] > 1)
+        continue;
+      if (!excusable)
+        return true;
+        
+      size_t a = buffers[buffer_ord[pos]].action;
+      if (a != NO_ACTION) { // the action would still add something without lit?
+        size_t lit_adds = 0;
+        for (int i = 0; i < numAdds(a); i++)
+          if ((size_t)getAdd(a,i) == lit)
+            lit_adds++;
+        if (minim_adds_in[a] > lit_adds)
+          return true;
+      }
+    }
+    return false;
+  }
+  
+  void minimRemove(size_t lit, bool inductive) {
+    size_t k = minim_lit_pos[lit];
+    for (size_t j = minim_occ_start[k]; j < minim_occ_start[k+1]; j++) {
+      size_t r = minim_occ[j];
+      if (minim_missing[r]++ == 0) {
+        size_t pos = minim_reason_pos[r];
+        if (--minim_covered[pos] == 0) {
+          minim_uncovered++;
+          if (inductive && minimBlocked(pos))
+            minim_failing++;
+        }
+      }
+    }
+    if (inductive)
+      for (size_t i = 0; i < numAdders(lit); i++) {
+        size_t a = getAdder(lit,i);
+        if (--minim_adds_in[a] == 0)
+          minimActionChanged(a,false);
+      }
+  }
+  
+  void minimPutBack(size_t lit, bool inductive) {
+    if (inductive)
+      for (size_t i = 0; i < numAdders(lit); i++) {
+        size_t a = getAdder(lit,i);
+        if (minim_adds_in[a]++ == 0)
+          minimActionChanged(a,true);
+      }
+    size_t k = minim_lit_pos[lit];
+    for (size_t j = minim_occ_start[k]; j < minim_occ_start[k+1]; j++) {
+      size_t r = minim_occ[j];
+      if (--minim_missing[r] == 0) {
+        size_t pos = minim_reason_pos[r];
+        if (minim_covered[pos]++ == 0) {
+          minim_uncovered--;
+          if (inductive && minimBlocked(pos))
+            minim_failing--;
+        }
+      }
+    }
+  }
+  
+  // the counters of minimBlocked and co. for the current working_state and used buffers
+  void minimInit(bool inductive) {
+    if (minim_adds_in.size() < (size_t)gnum_actions) {
+      minim_adds_in.assign(gnum_actions,0);
+      minim_buffer_pos.assign(gnum_actions,NO_ACTION);
+    }
+  
+    minim_covered.assign(buffer_ord.size(),0);
+    minim_reason_pos.clear();
+    minim_reason_at.clear();
+    if (minim_lit_pos.size() < sigsize)
+      minim_lit_pos.resize(sigsize);
+    for (size_t k = 0; k < union_lits.size(); k++)
+      minim_lit_pos[union_lits[k]] = k;
+    minim_occ_start.assign(union_lits.size()+1,0);
+    minim_noop_pos = NO_ACTION;
+    
+    // working_state only shrinks from now on, so just the reasons covered already can ever count
+    for (size_t pos = 0; pos < buffer_ord.size(); pos++) {
+      ClauseBuffer & buffer = buffers[buffer_ord[pos]];
+      if (buffer.action == NO_ACTION)
+        minim_noop_pos = pos;
+      else
+        minim_buffer_pos[buffer.action] = pos;
+      
+      size_t i = 0;
+      while (i < buffer.clauses.size()) {
+        size_t at = i;
+        size_t sz = buffer.clauses[i++];
+        size_t j = i;
+        while (j < i+sz && working_state[buffer.clauses[j]])
+          j++;
+        i += sz;
+        if (j < i)
+          continue;
+        
+        for (j = at+1; j < i; j++)
+          minim_occ_start[minim_lit_pos[buffer.clauses[j]]+1]++;
+        minim_covered[pos]++;
+        minim_reason_pos.push_back(pos);
+        minim_reason_at.push_back(at);
+      }
+    }
+    minim_missing.assign(minim_reason_pos.size(),0);
+    
+    for (size_t k = 0; k < union_lits.size(); k++)
+      minim_occ_start[k+1] += minim_occ_start[k];
+    minim_occ.resize(minim_occ_start[union_lits.size()]);
+    minim_occ_fill.assign(minim_occ_start.begin(),minim_occ_start.end()-1);
+    for (size_t r = 0; r < minim_reason_pos.size(); r++) {
+      vector<size_t> & clauses = buffers[buffer_ord[minim_reason_pos[r]]].clauses;
+      size_t at = minim_reason_at[r];
+      for (size_t j = at+1; j <= at+clauses[at]; j++)
+        minim_occ[minim_occ_fill[minim_lit_pos[clauses[j]]]++] = r;
+    }
+    
+    minim_noop_adders = 0;
+    if (inductive)
+      for (size_t k = 0; k < union_lits.size(); k++) {
+        size_t lit = union_lits[k];
+        if (working_state[lit])
+          for (size_t i = 0; i < numAdders(lit); i++) {
+            size_t a = getAdder(lit,i);
+            if (minim_adds_in[a]++ == 0 && !action_interesting[a])
+              minim_noop_adders++;
           }
+      }
+    
+    minim_uncovered = 0;
+    minim_failing = 0;
+    for (size_t pos = 0; pos < buffer_ord.size(); pos++)
+      if (!minim_covered[pos]) {
+        minim_uncovered++;
+        if (inductive && minimBlocked(pos))
+          minim_failing++;
+      }
+  }
+  
+  // back to all zeros / NO_ACTION, touching only what minimInit touched
+  void minimCleanup(bool inductive) {
+    if (inductive)
+      for (size_t k = 0; k < union_lits.size(); k++) {
+        size_t lit = union_lits[k];
+        for (size_t i = 0; i < numAdders(lit); i++)
+          minim_adds_in[getAdder(lit,i)] = 0;
+      }
+    
+    for (size_t pos = 0; pos < buffer_ord.size(); pos++) {
+      size_t a = buffers[buffer_ord[pos]].action;
+      if (a != NO_ACTION)
+        minim_buffer_pos[a] = NO_ACTION;
+    }
+  }
+
+  // drops the literals of working_state not needed to keep a reason from every used buffer (inductively, with cfg.minimize > 1)
+  void minimizeReason() {
+    stats.minim_attempted++;      
+  
+    // printf("Minimizing:\n");
+    lit_ord = union_lits;
+    randomShuffle(lit_ord); // TODO: could have better minimization heuristics (like avoiding the first action's reason first)
+    
+    bool inductive = (cfg.minimize > 1);
+    int goal_lits_remaining = 0;
+    if (inductive) {
+      for (size_t i = 0; i < union_lits.size(); i++)
+        if (goal_lits[union_lits[i]])
+          goal_lits_remaining++;
+    }
+    
+    minimInit(inductive);
+    
+    bool removed_something;
+    do {
+      removed_something = false;
+    
+      for (size_t lit_idx = 0; lit_idx < lit_ord.size(); lit_idx++) {
+        size_t lit = lit_ord[lit_idx];
+        if (!working_state[lit]) 
+          continue;
           
-          // we have a false clause 
-          plausible = false;
+        // could remove this guy
+        bool excusable = inductive && (goal_lits_remaining > (goal_lits[lit] ? 1 : 0));
+        if ((minim_uncovered && !excusable) || minimSurelyKept(lit,excusable))
+          continue;
+        
+        working_state[lit] = false;
+        if (inductive && goal_lits[lit])
+          goal_lits_remaining--;
+        minimRemove(lit,inductive);
+        
+        // we still "fit in" with the contributions if every buffer has a reason left or can use the inductive argument
+        if (minim_uncovered && (!goal_lits_remaining || minim_failing)) {
+          // put the literal back
+          working_state[lit] = true;
+          if (inductive && goal_lits[lit])
+            goal_lits_remaining++;
+          minimPutBack(lit,inductive);
+        } else {
+          // good riddance :)
+          removed_something = true;
+          stats.minim_litkilled++;
+        }
+      }
+    } while (cfg.minimize > 2 && removed_something);
+    
+    minimCleanup(inductive);
           
-          // all preserved negative literals get recorded
-          {
-            buffer.num_clauses++;
-            size_t new_cl_size = 0;
-            size_t new_cl_idx = buffer.clauses.size();
-            buffer.clauses.push_back(0);  // will update when we know the real size
-            for (size_t j = 0; j < cl.size(); j++)
-              if (!state[cl[j]]) { // was already false, so was preserved; the others were deleted explicitly so cannot be part of the reason clause
-                new_cl_size++;
-                buffer.clauses.push_back(cl[j]);
-                
-                //print_ft_name(cl[j]); printf(" ");
-              }
-            buffer.clauses[new_cl_idx] = new_cl_size; 
-          }
+    /*
+    fprintf(output,"Minimized to   ");
+    printState(working_state);      
+    */
+    
+    /*
+    if (chat) {
+      size_t sz = 0;
+      for (size_t i = 0; i < working_state.size(); i++)
+        if (working_state[i])
+          sz++;
+      fprintf(output,"Minimized to %zu\n",sz);
+    }
+    */
+  }
 
-          //printf("\n");                   
+  char extend(size_t layer_idx, BoolState const & state, bool chat = false) {           
+    // will be set to an actual action before returning result > 0  
+    extend_action_out = NO_ACTION;
+            
+    //printf("Extend into %zu:\n",layer_idx);
+    //printState(state);    
+    
+    /*
+     false clauses are those which the current state doesn't satisfy
+     it is typically much smaller set than the whole layers_delta[layer_idx]
+     
+     it pays off to focus on false clauses first
+     > for the positive case, we only look at the other clauses (which the action could have made false due to a delete effect)
+       when the action looks plausible (all precondintions are true in current and all false_clauses true in the successor)
+     > for the negative case (if the default quickreason is on) only plausible actions seek reasons
+       among the other clauses
+       
+     the "side" trick (the default resched = 2) returns an action as if it was a proper successor if it satisfies some false_clauses and does not undo validity any other clause
+    */
+    false_clauses.clear();
+    for (size_t i = 0; i < layers_delta[layer_idx].size(); i++) {
+      layers_delta[layer_idx][i]->layer_pos = i;
+      if (clauseUnsatisfied(layers_delta[layer_idx][i]->packed(),state)) {
+        // printf("False clause %zu: ",false_clauses.size()); printClauseNice(layers_delta[layer_idx][i]->lits());
+        false_clauses.push_back(i);
+      }
+    }
+    
+    // printf("Extending state into %zu; number of false clauses %zu\n",layer_idx,false_clauses.size());    
+    // printf("The state:\n"); printStateHash(state);
+    
+    assert(false_clauses.size() > 0); // there is always a false clause, otherwise <state> could already sit in layer_idx-th layer
+    // moreover, there is never a false clause from layers_deriv nor in invariant (that has been already checked "above")
+    
+    pruneInvalid(layers_deriv[layer_idx],layer_idx);
+    for (size_t i = 0; i < layers_deriv[layer_idx].size(); i++)
+      layers_deriv[layer_idx][i]->layer_pos = layers_delta[layer_idx].size() + i;
+    
+    // for implementing "side"
+    size_t best_action = NO_ACTION;
+    int best_false_after = (int)false_clauses.size(); // must improve to qualify    
+    
+    // for recording reasons of "interesting" actions
+    // interesting action is an action the reason set of which is not "SUBSUMED" by the reason set of NOOP (e.g. it must make at least one false_clase true)
+    // we don't need to record reasons of non-interesting actions (this tends to speedup subsequent overall-reason computation and minimization)
+    used_buffer_size = 0;
+    
+    assert(layer_idx < action_ords.size());    
+    vector<size_t> & actions_ord = action_ords[layer_idx];    
+    vector<size_t> & actions_pos = action_ord_pos[layer_idx];
+    
+    // the candidates (see extend_cands); the others would just be found not interesting
+    for (size_t i = 0; i < extend_cands.size(); i++)
+      action_interesting[extend_cands[i]] = false; // from the last time
+    extend_cands.clear();
+    cand_lits.clear();
+    cand_action_mark.resize(gnum_actions,0);
+    cand_lit_mark.resize(sigsize,0);
+    for (size_t i = 0; i < false_clauses.size(); i++) {
+      ClauseView cl = layers_delta[layer_idx][false_clauses[i]]->lits();
+      for (size_t n = 0; n < cl.size(); n++) {
+        size_t lit = cl[n];
+        if (cand_lit_mark[lit])
+          continue;
+        cand_lit_mark[lit] = 1;
+        cand_lits.push_back(lit);
+        for (size_t j = 0; j < numAdders(lit); j++) {
+          size_t a = getAdder(lit,j);
+          if (!cand_action_mark[a]) {
+            cand_action_mark[a] = 1;
+            extend_cands.push_back(a);
+          }
         }
-        
-        //if (chat) printf(" R: %zu\n",buffer.num_clauses);
-      }   
+      }
+    }
+    for (size_t i = 0; i < cand_lits.size(); i++)
+      cand_lit_mark[cand_lits[i]] = 0;
+    for (size_t i = 0; i < extend_cands.size(); i++)
+      cand_action_mark[extend_cands[i]] = 0;
+    sort(extend_cands.begin(),extend_cands.end(),CompareActionPositions(actions_pos));
+    
+    size_t plausible_idx = extend_cands.size(); // the position of the first plausible action (if any)
+
+    if (workers && extend_cands.size() >= PARALLEL_MIN_ACTIONS) {
+      /*
+       the workers try the actions with the initial threshold for "side";
+       since an outcome of tryAction does not depend on the other actions, merging them in the order then gives exactly what the sequential loop below would
+      */
+      job_layer_idx = layer_idx;
+      job_state = &state;
+      job_ord = &extend_cands;
+      job_side_threshold = best_false_after;
+      job_next = 0;
+      job_first_plausible = extend_cands.size();
       
-      // all clauses sat in new state
-      if (plausible) {
-        // printf("SAT\n"); 
+      workers->run(extendJob,this);
       
-        if (pushTest)
-          return 1;
+      plausible_idx = job_first_plausible;
+      for (size_t act_idx = 0; act_idx < plausible_idx; act_idx++) {
+        ActionOutcome & outcome = action_outcomes[act_idx];
+        action_scores[extend_cands[act_idx]] = outcome.score;
+        action_interesting[extend_cands[act_idx]] = outcome.interesting;
+      }
       
-        // there is a room for heuristics when picking just one next state        
-        // printf("Succesfully going forward!\n");      
-        extend_action_out = a;
+      if (plausible_idx == extend_cands.size()) 
+        for (size_t act_idx = 0; act_idx < extend_cands.size(); act_idx++) {
+          ActionOutcome & outcome = action_outcomes[act_idx];
+          
+          if (outcome.interesting) {
+            if (used_buffer_size < act_idx)
+              buffers[used_buffer_size].swap(buffers[act_idx]);
+            used_buffer_size++;
+          }
+          
+          if (outcome.side && outcome.false_after < best_false_after) {
+            best_false_after = outcome.false_after;
+            best_action = extend_cands[act_idx];
+          }
+        }
+    } else {
+      ExtendScratch & scratch = extend_scratch[0];
+      scratch.reset(state);
+      
+      for (size_t act_idx = 0; act_idx < extend_cands.size(); act_idx++) {
+        size_t a = extend_cands[act_idx];
         
-        // syst3: bring the successful action to front
-        for (size_t i = act_idx; i > 0; i--)
-          actions_ord[i] = actions_ord[i-1];
-        actions_ord[0] = action_idx;         
-              
-        // printAction(stdout,extend_action_out);
-        return 1;
-      }
-                  
-      if (can_do_side &&
-         isLayerState(layer_idx+1,working_state)) { /* since layers_deriv are sumbsumption reduced, 
-                                                    there is still a risk the successors does not satisfy all the layer clauses of its parent */                             
-        // printf("Improved best to %d with state:\n",false_after);
-        // printStateHash(working_state);      
-      
-        best_false_after = false_after;
-        best_action = a;
+        // the current buffer will get overwritten in the next round unless the action is interesting
+        ActionOutcome outcome = tryAction(scratch,layer_idx,state,false_clauses,false,a,buffers[used_buffer_size],best_false_after);
+        action_scores[a] = outcome.score;
+        action_interesting[a] = outcome.interesting;
+        
+        if (outcome.plausible) {
+          plausible_idx = act_idx;
+          break;
+        }
+        
+        if (outcome.interesting)
+          used_buffer_size++;
+          
+        if (outcome.side) {
+          // printf("Improved best to %d\n",outcome.false_after);
+          best_false_after = outcome.false_after;
+          best_action = a;
+        }
       }
+    }
+    
+#ifdef PDR_TRACE
+    extend_scanned = (plausible_idx < extend_cands.size()) ? plausible_idx+1 : extend_cands.size();
+#endif
+    
+    // all clauses sat in new state
+    if (plausible_idx < extend_cands.size()) {
+      // printf("SAT\n"); 
+    
+      // there is a room for heuristics when picking just one next state        
+      // printf("Succesfully going forward!\n");      
+      extend_action_out = extend_cands[plausible_idx];
       
-      next_action_1: 
-      // cleanup for the action
-      for (int i = 0; i < numPreconds(a); i++) 
-        false_precond_lits[getPrecond(a,i)] = false;            
+      // syst3: bring the successful action to front
+      for (size_t i = actions_pos[extend_action_out]; i > 0; i--) {
+        actions_ord[i] = actions_ord[i-1];
+        actions_pos[actions_ord[i]] = i;
+      }
+      actions_ord[0] = extend_action_out;         
+      actions_pos[extend_action_out] = 0;
+            
+      // printAction(stdout,extend_action_out);
+      return 1;
     }
     
     // all actions checked here !!!         
-    if (pushTest)
-      return 0;      
     
     // finishing the "side" trick
-    if (gcmd_line.resched == 2 && best_action != 0) {      
+    if (cfg.resched == 2 && best_action != NO_ACTION) {      
       extend_action_out = best_action;
       // printf("SIDE (%d)\n",best_false_after);
       // printAction(stdout,extend_action_out);
@@ -777,10 +2136,10 @@ struct SolvingContext {
     { 
       ClauseBuffer & buffer = buffers[used_buffer_size++];
       buffer.clear();
-      buffer.action = NULL;
+      buffer.action = NO_ACTION;
       
       for (size_t i = 0; i < false_clauses.size(); i++) {
-        Clause &cl = layers_delta[layer_idx][false_clauses[i]]->data;
+        ClauseView cl = layers_delta[layer_idx][false_clauses[i]]->lits();
         buffer.num_clauses++;
         buffer.clauses.push_back(cl.size());
         for (size_t j = 0; j < cl.size(); j++)
@@ -788,16 +2147,29 @@ struct SolvingContext {
       }
     }
     
-    // update the order for next time
-    stable_sort(actions_ord.begin(),actions_ord.end(),CompareActionScores(actions)); // low score is better
+    // update the order for next time: the candidates by their scores (low score is better), then the others, which could not help here, in their order
+    // (as a stable sort of all by score would do, with the others as bad as the useless actions)
+    stable_sort(extend_cands.begin(),extend_cands.end(),CompareActionScores(action_scores));
+    for (size_t i = 0; i < extend_cands.size(); i++)
+      cand_action_mark[extend_cands[i]] = 1;
+    action_ord_rest.clear();
+    for (size_t i = 0; i < actions_ord.size(); i++)
+      if (!cand_action_mark[actions_ord[i]])
+        action_ord_rest.push_back(actions_ord[i]);
+    copy(extend_cands.begin(),extend_cands.end(),actions_ord.begin());
+    copy(action_ord_rest.begin(),action_ord_rest.end(),actions_ord.begin()+extend_cands.size());
+    for (size_t i = 0; i < actions_ord.size(); i++)
+      actions_pos[actions_ord[i]] = i;
+    
+    for (size_t i = 0; i < extend_cands.size(); i++)
+      cand_action_mark[extend_cands[i]] = 0;
     
     /*
-    printf("Uptaded actions_ord for idx %zu:\n",layer_idx);
+    fprintf(output,"Uptaded actions_ord for idx %zu:\n",layer_idx);
     for (size_t act_idx = 0; act_idx < actions_ord.size(); act_idx++) {
       size_t action_idx = actions_ord[act_idx];
-      Action *a = actions[action_idx];
-      printf("Score: %d for ",a->score);
-      printAction(stdout,a);
+      fprintf(output,"Score: %d for ",action_scores[action_idx]);
+      printAction(output,action_idx);
     }
     */
     
@@ -816,74 +2188,12 @@ struct SolvingContext {
       }
       
       for (size_t i = 0; i < histogram_size; i++)
-        printf("%3d, ",reason_histogram[i]);
-      printf(" histogram for idx %zu\n",layer_idx);
+        fprintf(output,"%3d, ",reason_histogram[i]);
+      fprintf(output," histogram for idx %zu\n",layer_idx);
     }
     */
     
-    // prepare the conflict clause -- abusing the workingstate for that (to represent the union being built)
-    working_state.clear();
-    working_state.resize(sigsize,false);
-    
-    // resize buffer ord and sort it based on buffer sizes
-    randomPermutation(buffer_ord,used_buffer_size);   // TODO: could skip the random and use identity permutation instead (no big deal, would it speed up?)
-    sort(buffer_ord.begin(),buffer_ord.end(),CompareBufferSizes(buffers)); //start with small buffers            
-    
-    for (size_t act_idx = 0; act_idx < buffer_ord.size(); act_idx++) {
-      ClauseBuffer & buffer = buffers[buffer_ord[act_idx]];      
-      assert(buffer.num_clauses > 0);      
-      
-      /*
-      printf("%zu contributions of action %zu: ",buffer.num_clauses,buffer_ord[act_idx]);
-      if (buffer.action)
-        printAction(stdout,buffer.action);
-      else
-        printf("(NOOP)\n");
-      */
-      
-      size_t best_adds = sigsize+1;
-      size_t best_idx = 0;
-      
-      size_t i = 0;
-      size_t sz = 0;
-      while (i < buffer.clauses.size()) {
-        sz = buffer.clauses[i];
-        
-        size_t curbase = i;
-        size_t curadds = 0;
-        
-        while (i++,sz--) {
-          /*
-          print_ft_name(buffer.clauses[i]);
-          printf(" ");          
-          */
-          
-          if (!working_state[buffer.clauses[i]])
-            curadds++;
-        }
-        /*
-        printf("\n");        
-        */
-        if (curadds < best_adds) {
-          best_adds = curadds;
-          best_idx = curbase;
-        }        
-        
-        if (best_adds == 0) // no further improvement possible
-          break;
-      }
-      
-      assert(best_adds <= sigsize);
-      // if (chat) printf("- best adds %zu\n",best_adds);
-        
-      // apply the best guy
-      {
-        i = best_idx;
-        sz = buffer.clauses[i];
-        while (i++,sz--)
-          working_state[buffer.clauses[i]] = true;                                   
-      }
-    }
+    unionReasons();
       
     /*
     if (chat) {
@@ -891,173 +2201,112 @@ struct SolvingContext {
       for (size_t i = 0; i < working_state.size(); i++)
         if (working_state[i])
           sz++;
-      printf("Final size %zu\n",sz);
+      fprintf(output,"Final size %zu\n",sz);
     }
     */
       
     /*
-    printf("Derived clause ");
+    fprintf(output,"Derived clause ");
     printState(working_state);          
     */
     
-    if (gcmd_line.minimize) {
-      minim_attempted++;      
-    
-      // printf("Minimizing:\n");
-      randomPermutation(lit_ord,sigsize); // TODO: could have better minimization heuristics (like avoiding the first action's reason first)
-      
-      int goal_lits_remaining = 0;
-      if (gcmd_line.minimize > 1) {
-        for (size_t i = 0; i < sigsize; i++)
-          if (goal_lits[i] && working_state[i])
-            goal_lits_remaining++;
-      }
-      
-      bool removed_something;
-      do {
-        removed_something = false;
-      
-        for (size_t lit_idx = 0; lit_idx < sigsize; lit_idx++) {
-          if (working_state[lit_ord[lit_idx]]) { // could remove this guy
-            size_t saved = lit_ord[lit_idx];
-            working_state[saved] = false;
-            if (goal_lits[saved])
-              goal_lits_remaining--;
-            
-            // check if we still "fit in" with the contributions
-            for (size_t act_idx = 0; act_idx < buffer_ord.size(); act_idx++) {
-              ClauseBuffer & buffer = buffers[buffer_ord[act_idx]];      
-              size_t i = 0;
-              size_t sz = 0;              
-            
-              if (goal_lits_remaining) {       // can apply the inductive argument
-                assert(gcmd_line.minimize > 1);
-                
-                // can try the inductive reason first
-                if (buffer.action) {
-                  for (int i = 0; i < numAdds(buffer.action); i++) {
-                    int add = getAdd(buffer.action,i);
-                    if (working_state[add])
-                      goto all_the_standard_reasons_to_try;
-                  }
-                } else { // the NOOP action itself is never a problem, but it represents all the non-interesting actions which need to be tried, and why not try them now?
-                  for (Action* a = gactions; a; a = a->next) 
-                    if (!a->interesting)
-                      for (int i = 0; i < numAdds(a); i++) {
-                        int add = getAdd(a,i);
-                        if (working_state[add])
-                          goto all_the_standard_reasons_to_try;
-                      }
-                }
-                
-                // either NOOP, which always succeds inductively, or the action cannot make our current clause true anyway
-                goto next_action_2;
-              }
-              
-              all_the_standard_reasons_to_try: ;              
-
-              while (i < buffer.clauses.size()) {
-                sz = buffer.clauses[i++];
-                while (sz) {
-                  if (!working_state[buffer.clauses[i]])
-                    break;
-                  i++, sz--;
-                }
-                if (sz)
-                  i += sz;
-                else
-                  goto next_action_2; // the current is OK
-              }
-              
-              /*
-              printf("Kept "); print_ft_name(saved); printf(" also because of "); 
-              if (buffer.action)
-                printAction(stdout,buffer.action);
-              else
-                printf("(NOOP)\n");
-              */
-              
-              // none of them is good enough - put the literal back
-              working_state[saved] = true;
-              if (goal_lits[saved])
-                goal_lits_remaining++;
-              goto next_literal;
-              
-              next_action_2: ;
-            }
-          
-            // good riddance :)
-            removed_something = true;
-            minim_litkilled++;
-          }
-          
-          next_literal: ;
-        }
-      } while (gcmd_line.minimize > 2 && removed_something);
-            
-      /*
-      printf("Minimized to   ");
-      printState(working_state);      
-      */
-      
-      /*
-      if (chat) {
-        size_t sz = 0;
-        for (size_t i = 0; i < working_state.size(); i++)
-          if (working_state[i])
-            sz++;
-        printf("Minimized to %zu\n",sz);
-      }
-      */
-    }      
+    if (cfg.minimize) {
+      uint64_t start = nowNanos();
+      minimizeReason();
+      stats.time_minimizing.add(nowNanos() - start);
+    }
         
     extend_clause_out.clear();
-    for (size_t i = 0; i < working_state.size(); i++)
-      if (working_state[i])
-        extend_clause_out.push_back(i);    
+    for (size_t i = 0; i < union_lits.size(); i++)
+      if (working_state[union_lits[i]])
+        extend_clause_out.push_back(union_lits[i]);
+    sort(extend_clause_out.begin(),extend_clause_out.end());
     
     return 0;
   }
   
-  bool pruneLayerByClause(Clause const & cl, Clauses& layer, size_t idx, bool testForWeak, ClauseBox*& same_clause) {    
-    bool strong = true;    
+  bool pruneLayerByClause(ClauseView cl, Clauses& layer, size_t idx, bool testForWeak, ClauseBox*& same_clause) {    
     same_clause = 0;
     
-    // what happens in the cycle:
-    // 1. some clauses in layer may be invalid and should be deleted
-    // 2. among the rest, some may get subsumed and deleted
-    // 3. if the subsumed clause is equal to current, it is removed (but still alive) and returned as same_clause
-    // 3. if testForWeak, cl itself can get subsumed
-    // in any case we need to finish iterating to properly copy the rest of clauses and shrink the layer
-        
-    size_t j = 0;
-    for (size_t i = 0; i < layer.size(); i++) {
-      if (!layer[i]->validAt(idx)) {               
-        layer[i]->dec();
+    // layer is either layers_delta[idx] or layers_deriv[idx]; its (valid) members are recognized by their validity interval 
+    bool in_delta = (&layer == &layers_delta[idx]);
+    assert(in_delta || &layer == &layers_deriv[idx]);
+    
+    StateWord sig = clauseSignature(cl);
+    
+    // what happens here:
+    // 1. if testForWeak, cl itself can get subsumed (by a strictly smaller clause); then nothing else happens
+    // 2. otherwise, the clauses subsumed by cl get kicked from the layer
+    // 3. if a subsumed clause is equal to cl, it is removed (but still alive) and returned as same_clause
+    // 4. the layer gets compacted if anything was removed (including clauses which became invalid in the meantime)
+    
+    // 1. a subsuming clause must watch one of cl's literals
+    if (testForWeak) 
+      for (size_t i = 0; i < cl.size(); i++) {
+        Clauses &watch = clause_index.watching(cl[i]);
+        for (size_t j = 0; j < watch.size(); ) {
+          ClauseBox *clbox = watch[j];
+          if (clause_index.dropIfDead(watch,j))
+            continue; // a different box moved to position j
+          j++;
+          
+          if ((clbox->sig & ~sig) || clbox->num_lits >= cl.size() || 
+              !clbox->validAt(idx) || (clbox->from == idx) != in_delta)
+            continue;
+            
+          if (subsumes(clbox->lits(),cl))
+            return false;
+        }
+      }
+    
+    // 2. a subsumed clause must occur in the list of cl's rarest literal
+    assert(cl.size());
+    size_t rarest = cl[0];
+    for (size_t i = 1; i < cl.size(); i++)
+      if (clause_index[cl[i]].size() < clause_index[rarest].size())
+        rarest = cl[i];
+        
+    bool removed = false;
+    Clauses &occs = clause_index[rarest];
+    for (size_t j = 0; j < occs.size(); ) {
+      ClauseBox *clbox = occs[j];
+      if (clause_index.dropIfDead(occs,j))
+        continue; // a different box moved to position j
+      j++;
+      
+      if ((sig & ~clbox->sig) || clbox->num_lits < cl.size() || 
+          !clbox->validAt(idx) || (clbox->from == idx) != in_delta)
         continue;
+        
+      if (subsumes(cl,clbox->lits())) {
+        removed = true;
+        if (clbox->num_lits == cl.size()) {
+          //printf("same clause discovered in %zu\n",idx);
+          same_clause = clbox;
+        } else {
+          //printf("subsumes clause in %zu: ",idx); printClauseNice(clbox->lits());
+          clbox->kickedFrom(idx);
+          stats.cla_subsumed++;
+        }
       }
-      if (strong && !same_clause) {
-        if (subsumes(cl,layer[i]->data)) {
-          if (cl.size() == layer[i]->data.size()) {            
-            //printf("same clause discovered in %zu\n",idx);
-                      
-            same_clause = layer[i];
-          } else {
-            //printf("subsumes clause in %zu: ",idx); printClauseNice(layer[i]->data);
-          
-            layer[i]->kickedFrom(idx);
-            layer[i]->dec();
-            cla_subsumed++;           
-          }
-          continue;       // removed from layer
-          
-        } else if (testForWeak && subsumes(layer[i]->data,cl))
-          strong = false;
+    }
+    
+    // 4. compaction
+    if (removed) {
+      size_t j = 0;
+      for (size_t i = 0; i < layer.size(); i++) {
+        if (layer[i] == same_clause) // no dec(), the caller takes over the refcount point
+          continue;
+        if (!layer[i]->validAt(idx)) {
+          layer[i]->dec();
+          continue;
+        }
+        layer[j++] = layer[i]; //kept
       }
-      layer[j++] = layer[i]; //kept                       
+      layer.resize(j);
     }
-    layer.resize(j);
-    return strong;
+    
+    return true;
   }                     
     
   size_t insertClauseIntoLayers(Clause const & cl, size_t idx) {       
@@ -1066,7 +2315,7 @@ struct SolvingContext {
     ClauseBox* clbox = 0;
     
     // first its own layer (without obl_subsumption the clause may be too weak already in its own layer)
-    if (!pruneLayerByClause(cl,layers_delta[idx],idx,!gcmd_line.obl_subsumption,clbox)) {
+    if (!pruneLayerByClause(cl,layers_delta[idx],idx,!cfg.obl_subsumption,clbox)) {
       //printf("Subsumed in its own layer!\n");
       return 0;
     }
@@ -1075,7 +2324,7 @@ struct SolvingContext {
       layers_delta[idx].push_back(clbox);
       return 0;    
     }
-    if (!pruneLayerByClause(cl,layers_deriv[idx],idx,!gcmd_line.obl_subsumption,clbox)) {    
+    if (!pruneLayerByClause(cl,layers_deriv[idx],idx,!cfg.obl_subsumption,clbox)) {    
       // could this happen at all ?
       // printf("Expelled from its own layer!\n");
       return 0;
@@ -1090,7 +2339,7 @@ struct SolvingContext {
     assert(idx > 0);
     size_t i;
     for (i = idx-1; i > 0; i--) {
-      if (!gcmd_line.cla_subsumption) // we just use the fact that i was set to idx-1
+      if (!cfg.cla_subsumption) // we just use the fact that i was set to idx-1
         break;
     
       if (!pruneLayerByClause(cl,layers_delta[i],i,true,clbox))
@@ -1118,8 +2367,9 @@ struct SolvingContext {
     // printf("Too weak in %zu\n",i); //(including the case when i == 0, now)
         
     // creating box and putting where necessary
-    clbox = new ClauseBox(cl,idx);
+    clbox = ClauseBox::create(clause_pool,cl,idx);
     clbox->to = i+1;
+    clause_index.insert(clbox);
     layers_delta[idx].push_back(clbox->inc());    
     for (size_t j = idx-1; j > i; j--)
       layers_deriv[j].push_back(clbox->inc());
@@ -1128,7 +2378,7 @@ struct SolvingContext {
   }
 
   void processAndPrintSolution(FILE* outfile,Obligation* obl) {    
-    vector< pair<Action*,size_t> > plan;    
+    vector< pair<size_t,size_t> > plan;    
 
     // extract the plan 
     while (obl->parent) {
@@ -1137,8 +2387,8 @@ struct SolvingContext {
     }
     reverse(plan.begin(), plan.end());
           
-    if (gcmd_line.postprocess) { // Action Elimination (Nakhost & Mueller 2010)
-      times(&start);
+    if (cfg.postprocess) { // Action Elimination (Nakhost & Mueller 2010)
+      uint64_t start = nowNanos();
                   
       BoolState s = start_state, t;
       size_t i = 0;
@@ -1167,15 +2417,14 @@ struct SolvingContext {
         
         // NOTICE: no action is marked by i+1 at this moment
       }      
-      printf("Reduced to %zu actions.\n",plan.size());
+      fprintf(output,"Reduced to %zu actions.\n",plan.size());
       
-      times(&end);
-      TIME( time_postprocessing );
+      stats.time_postprocessing.add(nowNanos() - start);
     }
     
     // printing
     int idx, delta;
-    if (!gcmd_line.reverse) {
+    if (!cfg.reverse) {
       idx = 0;
       delta = 1;
     } else {
@@ -1189,10 +2438,115 @@ struct SolvingContext {
     }
   }  
   
+  // the obligations of obligations[from] whose states falsify the clause (new in layer to) move up to obligations[to]
+  void subsumeObligations(PackedClauseView pcl, size_t from, size_t to) {
+    if (cfg.obl_subsumption == 2 && to == phase) { // we put them to the grave when they go "off the rim"
+      
+      for (Obligation* tmp_obl = obligations[from].front(); tmp_obl; ) {
+        Obligation* next = tmp_obl->next;
+        oblState(tmp_obl,obl_state);
+        if (clauseUnsatisfied(pcl,obl_state)) {
+          obligations[from].remove(tmp_obl);
+          obl_grave.push_back(tmp_obl); // cannot delete directly, they may by part of the future plan
+          stats.oblig_killed++;
+        }
+        tmp_obl = next;
+      }
+    } else if (cfg.obl_subsumption) {
+      for (Obligation* tmp_obl = obligations[from].front(); tmp_obl; ) {
+        Obligation* next = tmp_obl->next;
+        oblState(tmp_obl,obl_state);
+        if (clauseUnsatisfied(pcl,obl_state)) {
+          obligations[from].remove(tmp_obl);
+          obligations[to].push_back(tmp_obl);
+          stats.oblig_subsumed++;
+        }
+        tmp_obl = next;
+      }
+    }
+  }
+  
+  // whether a box with exactly these literals is still used in the layers, or the clause is subsumed by one valid in layer idx
+  bool knownClause(ClauseView cl, size_t idx) {
+    size_t rarest = cl[0];
+    for (size_t i = 1; i < cl.size(); i++)
+      if (clause_index[cl[i]].size() < clause_index[rarest].size())
+        rarest = cl[i];
+        
+    Clauses &occs = clause_index[rarest];
+    for (size_t j = 0; j < occs.size(); j++) {
+      ClauseBox *clbox = occs[j];
+      if (!ClauseIndex::isDead(clbox) && clbox->num_lits == cl.size() && subsumes(cl,clbox->lits()))
+        return true;
+    }
+    
+    StateWord sig = clauseSignature(cl);
+    for (size_t i = 0; i < cl.size(); i++) {
+      Clauses &watch = clause_index.watching(cl[i]);
+      for (size_t j = 0; j < watch.size(); j++) {
+        ClauseBox *clbox = watch[j];
+        if (!ClauseIndex::isDead(clbox) && !(clbox->sig & ~sig) && clbox->num_lits <= cl.size() && 
+            clbox->validAt(idx) && subsumes(clbox->lits(),cl))
+          return true;
+      }
+    }
+    return false;
+  }
+  
+  /*
+   takes over the clauses published by the other members of the portfolio since the last call (a safe point between two obligations)
+   a clause is valid in the layer where its author derived it, but it need not be inductive relative to our (possibly weaker) previous layer;
+   inserting it anyway could make a layer look like a fixpoint which is not one, so it has to pass the push test from there first;
+   a clause we already have (in whichever layer) or which is too weak for the layer is skipped (a derived one can be weak in its own layer,
+   but an imported one can't be trusted not to meet a second box of itself when pushing then)
+   returns true if a layer got emptied (UNSAT)
+  */
+  bool importClauses() {
+    ClauseExchange& exchange = *portfolio->exchange;
+    size_t idx;
+    
+    for (size_t m = 0; m < import_cursors.size(); m++) {
+      if ((int)m == portfolio_idx)
+        continue;
+    
+      while (exchange.fetch(import_cursors[m],idx,import_clause)) {
+        if (idx > phase)
+          idx = phase;
+        
+        pruneInvalid(layers_deriv[idx-1],idx-1);
+        if (knownClause(import_clause,idx) || !pushTest(extend_scratch[0],idx-1,import_clause)) {
+          stats.cla_rejected++;
+          continue;
+        }
+        stats.cla_imported++;
+        
+        if (idx < least_affected_layer)
+          least_affected_layer = idx;
+        
+        uint64_t start = nowNanos();
+        size_t empty_layer = insertClauseIntoLayers(import_clause,idx);
+        stats.time_subsumption.add(nowNanos() - start);
+        if (empty_layer) {
+          if (cfg.obl_survive < 2)
+            fprintf(output,"UNSAT: repetition detected!\nDelta-layer %zu emptied by subsumption!\n",empty_layer);
+          else
+            fprintf(output,"UNRESOLVED: repetition detected under incompete setup!\nDelta-layer %zu emptied by subsumption!\n",empty_layer);
+          return true;
+        }
+        
+        packClause(import_clause,import_packed);
+        for (size_t i = 0; i < idx; i++)
+          subsumeObligations(import_packed,i,idx);
+      }
+    }
+    
+    return false;
+  }
+  
   bool processObligations() {
     assert(phase);
     
-    assert(gcmd_line.resched < 2 || gcmd_line.oblig_prior_stack); 
+    assert(cfg.resched < 2 || cfg.oblig_prior_stack); 
     /* "side" is a bit weird. 
         We don't guarantee that a state will not generate the same side next time it is considered.
         This may lead to problems with "oblig_prior_queue" as exemplified on the WOODWORKING domain.
@@ -1209,17 +2563,24 @@ struct SolvingContext {
     
     size_t obl_top = phase-1;  
     for(;;) {      
-      assert(obligations[0].size() <= 1 || gcmd_line.resched > 1); // The first stack is always trivial, unless we do sidestepping
+      if (stopped())
+        return true;
+        
+      if (portfolio && portfolio->exchange && importClauses())
+        return true;
+    
+      assert(obligations[0].size() <= 1 || cfg.resched > 1); // The first stack is always trivial, unless we do sidestepping
     
       while (obl_top < phase && obligations[obl_top].size() == 0)
         obl_top++;
         
       if (obl_top == phase) {
-        if (!gcmd_line.obl_survive) { 
+        if (!cfg.obl_survive) { 
           // free obligations and next phases starts from scratch
           while (!obligations[phase].empty()) {
-            delete obligations[phase].back();
+            Obligation* obl = obligations[phase].back();
             obligations[phase].pop_back();
+            releaseObligation(obl);
           }
         }
                          
@@ -1227,7 +2588,7 @@ struct SolvingContext {
       }
       
       Obligation* obl;
-      if (gcmd_line.oblig_prior_stack) {   // stack-wise handling of obligations favours long plans in a certain sense
+      if (cfg.oblig_prior_stack) {   // stack-wise handling of obligations favours long plans in a certain sense
         obl = obligations[obl_top].back();
         obligations[obl_top].pop_back();           
       } else {
@@ -1235,8 +2596,14 @@ struct SolvingContext {
         obligations[obl_top].pop_front();           
       }
       
-      // printf("Handling obligation with depth %zu and state of size %zu\n",obl->depth,obl->state.size());
-      oblig_processed++;
+      // printf("Handling obligation with depth %zu\n",obl->depth);
+      stats.oblig_processed++;
+      
+      if (obl != cached_obl) {
+        oblState(obl,obl_state);
+        cached_state.swap(obl_state);
+        cached_obl = obl;
+      }
       
       if (obl_top < path_min_layer)
         path_min_layer = obl_top;
@@ -1244,32 +2611,46 @@ struct SolvingContext {
       if (obl_top+1 < least_affected_layer)
         least_affected_layer = obl_top+1;
         
-      times(&start);
+      uint64_t start = nowNanos();
       
-      char res;      
-      if ((res = extend(obl_top,obl->state,false))) { 
-        times(&end);
-        TIME( time_extend_sat );
+      char res = extend(obl_top,cached_state,false);
       
+      uint64_t elapsed = nowNanos() - start;
+      if (obl_top >= stats.extend_latency.size())
+        stats.extend_latency.resize(obl_top+1);
+      stats.extend_latency[obl_top].add(elapsed);
+      
+#ifdef PDR_TRACE
+      if (trace && trace->sampled())
+        trace->complete("extend","extend",portfolio_idx,start,start+elapsed,"\"layer\":%zu,\"result\":\"%s\",\"actions\":%zu,\"buffers\":%zu",
+          obl_top,res ? (res > 1 ? "side" : "SAT") : "UNSAT",extend_scanned,used_buffer_size);
+#endif
+      
+      if (res) { 
         if (res > 1) {
-          oblig_side++;          
+          stats.oblig_side++;          
+          stats.time_extend_side.add(elapsed);
         } else {
-          oblig_sat++;          
+          stats.oblig_sat++;          
+          stats.time_extend_sat.add(elapsed);
         }        
       
         // the parent goes back
-        if (gcmd_line.obl_survive < 2) /* gcmd_line.obl_survive == 2 is incomplete! */
+        if (cfg.obl_survive < 2) /* cfg.obl_survive == 2 is incomplete! */
           obligations[obl_top].push_back(obl);
         else  
           obl_grave.push_back(obl);          
       
         // going forward     
-        assert(extend_action_out != NULL);
+        assert(extend_action_out != NO_ACTION);
         {
-          Obligation* new_obl = new Obligation(obl,extend_action_out);
-          new_obl->depth = obl->depth+1;
-          new_obl->state = obl->state;
-          applyActionEffects(new_obl->state,extend_action_out);
+          obl_state = cached_state;
+          applyActionEffects(obl_state,extend_action_out);
+          Obligation* new_obl = newObligation(obl,extend_action_out,obl_state);
+          
+          // the new guy is the one to be handled next (at least with oblig_prior_stack)
+          cached_state.swap(obl_state);
+          cached_obl = new_obl;
                     
           //printf("Extended by action "); printAction(stdout,extend_action_out);          
               
@@ -1277,22 +2658,27 @@ struct SolvingContext {
             obligations[obl_top].push_back(new_obl);    
           } else {
             if (obl_top == 0) {
-              printf("SAT: plan of length %zu found\n",new_obl->depth);
+              if (!claimAnswer()) {
+                releaseObligation(new_obl);
+                return true;
+              }
+            
+              fprintf(output,"SAT: plan of length %zu found\n",new_obl->depth);
               
               string filename;
-              filename += gcmd_line.path;
-              filename += gcmd_line.fct_file_name;
+              filename += cfg.path;
+              filename += cfg.fct_file_name;
               filename += ".soln";
                          
               FILE* outfile = fopen(filename.c_str(),"w");              
               if (!outfile)
-                printf("%s\n",strerror(errno));              
+                fprintf(output,"%s\n",strerror(errno));              
               else {
                 processAndPrintSolution(outfile,new_obl);
                 fclose(outfile);
               }
               
-              delete new_obl;         
+              releaseObligation(new_obl);
               return true;
             }
           
@@ -1306,68 +2692,78 @@ struct SolvingContext {
           obl_top--; // going forward with the new guy(s)
              
       } else {
-        oblig_unsat++;        
-        
-        times(&end);
-        TIME( time_extend_uns );
+        stats.oblig_unsat++;        
+        stats.time_extend_uns.add(elapsed);
       
         {
-          cla_derived++;
+          stats.cla_derived++;
           
+          start = nowNanos();
+#ifdef PDR_TRACE
+          size_t subsumed_before = stats.cla_subsumed;
+#endif
           size_t empty_layer = insertClauseIntoLayers(extend_clause_out,obl_top+1);
+          stats.time_subsumption.add(nowNanos() - start);
+#ifdef PDR_TRACE
+          if (trace && trace->sampled())
+            trace->complete("clauses","insert clause",portfolio_idx,start,nowNanos(),"\"layer\":%zu,\"size\":%zu,\"subsumed\":%zu",
+              obl_top+1,extend_clause_out.size(),stats.cla_subsumed-subsumed_before);
+#endif
+          packClause(extend_clause_out,extend_packed_out);
           
           if (empty_layer) {
-            if (gcmd_line.obl_survive < 2)
-              printf("UNSAT: repetition detected!\nDelta-layer %zu emptied by subsumption!\n",empty_layer);
+            if (cfg.obl_survive < 2)
+              fprintf(output,"UNSAT: repetition detected!\nDelta-layer %zu emptied by subsumption!\n",empty_layer);
             else
-              printf("UNRESOLVED: repetition detected under incompete setup!\nDelta-layer %zu emptied by subsumption!\n",empty_layer);
-            delete obl;          
+              fprintf(output,"UNRESOLVED: repetition detected under incompete setup!\nDelta-layer %zu emptied by subsumption!\n",empty_layer);
+            releaseObligation(obl);
             return true;
           }            
         
-          // obligation subsumption
-          if (gcmd_line.obl_subsumption == 2 && obl_top+1 == phase) { // we put them to the grave when they go "off the rim"
-            
-            for (Obligations::iterator it = obligations[obl_top].begin(); it != obligations[obl_top].end(); ) {
-              Obligation* tmp_obl = *it;
-              if (clauseUnsatisfied(extend_clause_out,tmp_obl->state)) {
-                it = obligations[obl_top].erase(it);
-                obl_grave.push_back(tmp_obl); // cannot delete directly, they may by part of the future plan
-                oblig_killed++;
-              } else {
-                ++it;
-              }
-            }
-          } else if (gcmd_line.obl_subsumption) {
-            for (Obligations::iterator it = obligations[obl_top].begin(); it != obligations[obl_top].end(); ) {
-              Obligation* tmp_obl = *it;
-              if (clauseUnsatisfied(extend_clause_out,tmp_obl->state)) {
-                it = obligations[obl_top].erase(it);
-                obligations[obl_top+1].push_back(tmp_obl);
-                oblig_subsumed++;
-              } else {
-                ++it;
-              }
-            }
+          subsumeObligations(extend_packed_out,obl_top,obl_top+1);
+          
+          if (portfolio && portfolio->exchange && extend_clause_out.size() <= (size_t)cfg.share_clauses) {
+            portfolio->exchange->publish(portfolio_idx,obl_top+1,extend_clause_out);
+            stats.cla_exported++;
           }
         }
                    
         //rescheduling
-        if (gcmd_line.resched)
+        if (cfg.resched)
           obligations[obl_top+1].push_back(obl);
         else 
-          delete obl;
+          releaseObligation(obl);
       }
     }  
   }
   
-  BoolState pushState;
-  
   bool clausePushing() {
     // printf("clausePushing\n");
     
     assert(layers_delta.size() == phase+2);     
     for (size_t idx = least_affected_layer; idx <= phase; idx++) {
+      if (stopped())
+        return true;
+        
+#ifdef PDR_TRACE
+      uint64_t layer_start = nowNanos();
+      size_t pushed_before = stats.cla_pushed;
+      size_t tested = layers_delta[idx].size();
+#endif
+        
+      pruneInvalid(layers_deriv[idx],idx);
+    
+      // the push tests of a layer don't depend on each other (a clause pushed from idx is still there in layers_deriv[idx]),
+      // so they can all be run against the layer as it is now and only then acted upon in the order
+      push_results.resize(layers_delta[idx].size());
+      if (workers && layers_delta[idx].size() > 1) {
+        job_layer_idx = idx;
+        job_next = 0;
+        workers->run(pushJob,this);
+      } else
+        for (size_t i = 0; i < layers_delta[idx].size(); i++)
+          push_results[i] = !pushTest(extend_scratch[0],idx,layers_delta[idx][i]->lits());
+    
       size_t j = 0;
       for (size_t i = 0; i < layers_delta[idx].size(); i++) {
         ClauseBox* clbox = layers_delta[idx][i];
@@ -1376,31 +2772,26 @@ struct SolvingContext {
         // yes, but since the_clause goes to false_clases anyway the only way to speed it up would be to force false_clase = { the_clause } (only true when clause subsumption is on)
         // the saving is then not per every action, but only once per call to extend - seems not to pay off
         
-        pushState.clear();
-        pushState.resize(sigsize,true);
-        for (size_t n = 0; n < clbox->data.size(); n++)
-          pushState[clbox->data[n]] = false;
+        // printf("Trying clause from layer %zu: ",idx); printClauseNice(clbox->lits());
         
-        // printf("Trying clause from layer %zu: ",idx); printClauseNice(clbox->data);
-        
-        if (extend(idx,pushState,true)) { // SAT -> not pushed
+        if (push_results[i]) { // SAT -> not pushed
           layers_delta[idx][j++] = clbox;
         } else {       
-          // printf("Pushing clause from layer %zu: ",idx); printClauseNice(clbox->data);
-          cla_pushed++;
+          // printf("Pushing clause from layer %zu: ",idx); printClauseNice(clbox->lits());
+          stats.cla_pushed++;
           
           ClauseBox* dummy = 0; 
           
-          bool res = pruneLayerByClause(clbox->data,layers_delta[idx+1],idx+1,false,dummy);          
+          bool res = pruneLayerByClause(clbox->lits(),layers_delta[idx+1],idx+1,false,dummy);          
           assert(res && !dummy);
           
           // TODO: why not prune in deriv as well? could it not be harmfull, to keep them there? Think:
           /*
-          size_t before = cla_subsumed;          
-          res = pruneLayerByClause(clbox->data,layers_deriv[idx+1],idx+1,false,dummy);          
+          size_t before = stats.cla_subsumed;          
+          res = pruneLayerByClause(clbox->lits(),layers_deriv[idx+1],idx+1,false,dummy);          
           assert(res && !dummy);          
-          if (cla_subsumed > before)
-            printf("Subsumed in deriv!\n");
+          if (stats.cla_subsumed > before)
+            fprintf(output,"Subsumed in deriv!\n");
           */
           
           layers_deriv[idx].push_back(clbox); // inheriting the refcount point from layers_delta[idx] from where we remove it
@@ -1408,30 +2799,36 @@ struct SolvingContext {
           layers_delta[idx+1].push_back(clbox->inc());
 
           // obl_subsumption is obligatory in pushing when obl_survive, otherwise we could later violate `false_clauses.size() > 0' in extend...
-          assert(!gcmd_line.obl_survive || gcmd_line.obl_subsumption); 
+          assert(!cfg.obl_survive || cfg.obl_subsumption); 
                     
-          if (gcmd_line.obl_subsumption) {            
-            for (Obligations::iterator it = obligations[idx].begin(); it != obligations[idx].end(); ) {
+          if (cfg.obl_subsumption) {            
+            for (Obligation* tmp_obl = obligations[idx].front(); tmp_obl; ) {
               assert(idx == phase); // as we currently only call pushing between phases, only the obligations[phase] are possibly non-empty and that only in survive mode
-              Obligation* tmp_obl = *it;
-              if (clauseUnsatisfied(clbox->data,tmp_obl->state)) {
-                it = obligations[idx].erase(it);
+              Obligation* next = tmp_obl->next;
+              oblState(tmp_obl,obl_state);
+              if (clauseUnsatisfied(clbox->packed(),obl_state)) {
+                obligations[idx].remove(tmp_obl);
                 obligations[idx+1].push_back(tmp_obl);
-                oblig_subsumed++;
-              } else {
-                ++it;
+                stats.oblig_subsumed++;
               }
+              tmp_obl = next;
             }
           }          
         }
       }
       layers_delta[idx].resize(j);
+      
+#ifdef PDR_TRACE
+      if (trace)
+        trace->complete("pushing","push layer",portfolio_idx,layer_start,nowNanos(),"\"layer\":%zu,\"tested\":%zu,\"pushed\":%zu",
+          idx,tested,stats.cla_pushed-pushed_before);
+#endif
     
       if (layers_delta[idx].size() == 0) {
-        if (gcmd_line.obl_survive < 2)
-          printf("UNSAT: repetition detected!\nDelta-layer %zu emptied by pushing!\n",idx);
+        if (cfg.obl_survive < 2)
+          fprintf(output,"UNSAT: repetition detected!\nDelta-layer %zu emptied by pushing!\n",idx);
         else
-          printf("UNRESOLVED: repetition detected under incompete setup!\nDelta-layer %zu emptied by pushing!\n",idx);
+          fprintf(output,"UNRESOLVED: repetition detected under incompete setup!\nDelta-layer %zu emptied by pushing!\n",idx);
           
         return true;
       }
@@ -1445,18 +2842,15 @@ struct SolvingContext {
 
   bool stateNotModel(BoolState& s, Clauses& layer) {
     for (size_t i = 0; i < layer.size(); i++)
-      if (clauseUnsatisfied(layer[i]->data,s))
+      if (clauseUnsatisfied(layer[i]->packed(),s))
         return true;
     return false;
   }
   
   bool stateNotOfInvariant(BoolState& s) {
-    Clause cur_clause;
-    for (size_t i = 0; i < invariant.size(); i++) {
-      invariant.loadClause(i,cur_clause);
-      if (clauseUnsatisfied(cur_clause,s))
+    for (size_t i = 0; i < invariant.size(); i++)
+      if (invariant.clauseUnsatisfied(i,s))
         return true;
-    }     
     return false;
   }  
   
@@ -1468,6 +2862,10 @@ struct SolvingContext {
 
     assert(layers_delta.size() == 1);  // already filled by caller
     assert(layers_deriv.size() == 0);
+    
+    clause_index.resize(sigsize);
+    for (size_t i = 0; i < layers_delta[0].size(); i++)
+      clause_index.insert(layers_delta[0][i]);
     layers_deriv.push_back(Clauses()); // catch up with layers_delta
        
     assert(obligations.size() == 0);
@@ -1476,57 +2874,61 @@ struct SolvingContext {
     //printf("Loading %d actions.\n",gnum_actions);    
     
     // temporaries needed for extending state
-    actions.reserve(gnum_actions);
-    for (Action* a = gactions; a; a = a->next) {
-      // printf("Checking action "); printAction(stdout,a);
-      actions.push_back(a);
-    }
+    action_scores.resize(gnum_actions,0);
+    action_interesting.resize(gnum_actions,0);
     buffers.resize(gnum_actions+1, ClauseBuffer()); // the last guy represents the "no-op" that ensures monotonicity                 
+    
+    if (cfg.threads > 1) {
+      workers = new WorkerPool(cfg.threads);
+      action_outcomes.resize(gnum_actions);
+    }
+    extend_scratch.resize(workers ? workers->size() : 1);
      
     // extend one more step - to be ready for phase 1
     layers_delta.push_back(Clauses());
     layers_deriv.push_back(Clauses());
     obligations.push_back(Obligations());
         
-    action_ords.push_back(vector<size_t>());
-    randomPermutation(action_ords.back(),gnum_actions);    
+    newActionOrder();
            
     if (stateNotOfInvariant(start_state)) {
-      printf("UNSAT: initial state doesn't satisfy the backward invariant!\n");
+      fprintf(output,"UNSAT: initial state doesn't satisfy the backward invariant!\n");
       return;
     }   
         
     for (phase = 1 ;; phase++) {    
-      if (gcmd_line.pphase == 1)
-        printf("Phase %zu\n",phase);        
+      if (cfg.pphase == 1)
+        fprintf(output,"Phase %zu\n",phase);        
+        
+#ifdef PDR_TRACE
+      trace_phase_start = nowNanos();
+#endif
     
-      if (gcmd_line.phaselim && (int)phase > gcmd_line.phaselim) {
-        printf("UNRESOLVED: Phase limit reached!\n");        
+      if (cfg.phaselim && (int)phase > cfg.phaselim) {
+        fprintf(output,"UNRESOLVED: Phase limit reached!\n");        
         return;
       }
       
-      bool reinsert_initial = (!gcmd_line.obl_survive || !gcmd_line.resched || phase == 1 || gcmd_line.obl_subsumption == 2);
+      bool reinsert_initial = (!cfg.obl_survive || !cfg.resched || phase == 1 || cfg.obl_subsumption == 2);
       bool result = false;
       
-      if (reinsert_initial && (gcmd_line.cla_subsumption == 2) && stateNotModel(start_state,layers_delta[phase])) {
-        if (gcmd_line.pphase == 1)
-            printf("Skipped - initial state doesn't satisfy pushed clauses!\n");      
+      if (reinsert_initial && (cfg.cla_subsumption == 2) && stateNotModel(start_state,layers_delta[phase])) {
+        if (cfg.pphase == 1)
+            fprintf(output,"Skipped - initial state doesn't satisfy pushed clauses!\n");      
       } else {
         if (reinsert_initial) {
-          Obligation* obl = new Obligation(NULL,NULL); // the initial guy has no parents
-          obl->depth = 0;
-          obl->state = start_state;
+          Obligation* obl = newObligation(NULL,NO_ACTION,start_state); // the initial guy has no parents
           obligations[phase-1].push_front(obl); // so that it is picked last with oblig_prior_stack+obl_survive+obl_subsumption=2        
         }
         result = processObligations();
       }
-      if (gcmd_line.pphase == 2) {
+      if (cfg.pphase == 2) {
         for (size_t i = 0; i < phase; i++)
           if (i < path_min_layer)
-            printf(".");
+            fprintf(output,".");
           else
-            printf("*");
-        printf("\n");
+            fprintf(output,"*");
+        fprintf(output,"\n");
 
         path_min_layer = phase+1;
       }
@@ -1539,38 +2941,221 @@ struct SolvingContext {
       layers_deriv.push_back(Clauses());
       obligations.push_back(Obligations());
       
-      action_ords.push_back(vector<size_t>());
-      randomPermutation(action_ords.back(),gnum_actions);
+      newActionOrder();
       
-      if (gcmd_line.cla_subsumption == 2) { // clause pushing
-        times(&start);
+      if (cfg.cla_subsumption == 2) { // clause pushing
+        uint64_t start = nowNanos(), cpu_start = threadCpuNanos();
+        push_workers_cpu = 0;
         bool done = clausePushing();
-        times(&end);
-        TIME( time_pushing );
+        stats.time_pushing.add(nowNanos() - start);
+#ifdef PDR_TRACE
+        if (trace)
+          trace->complete("pushing","pushing",portfolio_idx,start,nowNanos(),"\"phase\":%zu",phase);
+#endif
+        stats.time_pushing_cpu += (threadCpuNanos() - cpu_start + push_workers_cpu)*1e-9;
         
         if (done)
           return;        
       }
+      
+      clause_index.collectGarbage(); // not to let the lists of rarely deleted literals fill up with dead boxes
 
-      if (gcmd_line.pphase == 1) {
+      if (stats_stream)
+        recordStats(false);
+        
+#ifdef PDR_TRACE
+      traceEndOfPhase();
+#endif
+      
+      if (cfg.pphase == 1) {
         printStat();
         /*
-        printf("Layers: ----------------------------- \n");
+        fprintf(output,"Layers: ----------------------------- \n");
         printLayers();
-        printf("------------------------------------- \n");
+        fprintf(output,"------------------------------------- \n");
         */
       }
     }  
   }  
 } context;
 
+// (compiled with PDR_NO_MAIN, the file is included by the microbenchmarks, which have their own main)
+#ifndef PDR_NO_MAIN
+// while a portfolio (-P) runs; the global context is not used then
+static Portfolio* running_portfolio = 0;
+
 static void SIGINT_exit(int signum) {
+  // the members are running, so just tell them to stop; runPortfolio prints their statistics after they have
+  // (a second interrupt, e.g. when they take too long, exits right away)
+  if (running_portfolio && !running_portfolio->interrupted) {
+    running_portfolio->interrupted = 1;
+    return;
+  }
   printf("*** INTERRUPTED ***\n");    
-  context.printGOStat();
+  if (!running_portfolio)
+    context.printGOStat();
+#ifdef PDR_TRACE
+  gtrace.close();
+#endif
   fflush(stdout);  
   _exit(1);
 }
 
+// fills in the problem (ctx.cfg must already be set)
+static void initContext(SolvingContext& ctx, BoolState const& start_state, Clause const& target_condition, BinClauseBuffer const& invariant) {
+  Clause temp_clause;
+  ctx.layers_delta.push_back(Clauses());    
+  Clauses& target_layer = ctx.layers_delta[0];     
+  
+  //signature
+  ctx.sigsize = gnum_relevant_facts;
+  
+  //start
+  ctx.start_state = start_state;       
+  
+  //goal - putting into layers and also into goal_lits for fast random access with induction
+  ctx.goal_lits.resize(gnum_relevant_facts,false);    
+  
+  for (size_t i = 0; i < target_condition.size(); i++ ) {
+    temp_clause.clear();
+    temp_clause.push_back(target_condition[i]);                
+    ClauseBox* clbox = ClauseBox::create(ctx.clause_pool,temp_clause,0);     
+    target_layer.push_back(clbox->inc());    
+    
+    if (ctx.cfg.minimize > 1)
+      ctx.goal_lits[target_condition[i]] = true;       
+  }
+  
+  ctx.invariant = invariant;
+}
+
+/*
+ the portfolio (-P n) runs n contexts in parallel, each with its own variant of the options and its own random orderings,
+ and stops them all as soon as one of them answers; only the output of that one is printed.
+ member i takes the i-th variant below (cyclically), -1 meaning "as given on the command line"; member 0 is exactly the plain run.
+ (the search direction stays as given, as the action table is shared)
+*/
+struct PortfolioVariant {
+  int oblig_prior_stack;
+  int resched;
+  int minimize;
+  int quick_reason;
+};
+
+static const PortfolioVariant portfolio_variants[] = {
+  { -1, -1, -1, -1 },
+  {  0,  1, -1, -1 },
+  { -1, -1,  1, -1 },
+  { -1, -1, -1,  0 },
+  {  1,  1, -1, -1 },
+  { -1, -1,  2,  2 },
+  {  0,  0, -1, -1 },
+  {  1,  0,  0, -1 }
+};
+static const size_t num_portfolio_variants = sizeof(portfolio_variants)/sizeof(portfolio_variants[0]);
+
+static void portfolioJob(void* members, size_t worker) {
+  SolvingContext* ctx = ((SolvingContext**)members)[worker];
+  ctx->solve();
+  if (!ctx->stopped())
+    ctx->claimAnswer(); // an UNSAT (or UNRESOLVED) answer; does nothing if the plan has already been claimed
+}
+
+static void runPortfolio(size_t size, BoolState const& start_state, Clause const& target_condition, BinClauseBuffer const& invariant, FILE* stats_stream) {
+  Portfolio portfolio;
+  if (gcmd_line.share_clauses) {
+    if (gcmd_line.obl_subsumption) 
+      portfolio.exchange = new ClauseExchange(size);
+    else // an imported clause must take the obligations it blocks out of their layers, as a derived one does
+      printf("Sharing clauses needs obligation subsumption (-s 1 or 2), switched off.\n");
+  }
+  if (gcmd_line.replay_file[0]) // the members race each other, so there is no single run to record
+    printf("Replay logs are not supported in a portfolio, ignored.\n");
+  vector<SolvingContext*> members(size);
+  
+  for (size_t i = 0; i < size; i++) {
+    SolvingContext* ctx = members[i] = new SolvingContext;
+    
+    PortfolioVariant const & variant = portfolio_variants[i % num_portfolio_variants];
+    ctx->cfg = gcmd_line;
+    if (variant.oblig_prior_stack >= 0)
+      ctx->cfg.oblig_prior_stack = variant.oblig_prior_stack;
+    if (variant.resched >= 0)
+      ctx->cfg.resched = variant.resched;
+    if (variant.minimize >= 0)
+      ctx->cfg.minimize = variant.minimize;
+    if (variant.quick_reason >= 0)
+      ctx->cfg.quick_reason = variant.quick_reason;
+    
+    ctx->seedRandom(gcmd_line.seed+i);
+    
+    ctx->output = tmpfile();
+    if (!ctx->output) {
+      printf("%s\n",strerror(errno));
+      exit(1);
+    }
+    ctx->portfolio = &portfolio;
+    ctx->stats_stream = stats_stream;
+#ifdef PDR_TRACE
+    if (gtrace.active())
+      ctx->trace = &gtrace;
+#endif
+    ctx->portfolio_idx = i;
+    if (portfolio.exchange)
+      for (size_t m = 0; m < size; m++)
+        ctx->import_cursors.push_back(portfolio.exchange->begin(m));
+    
+    initContext(*ctx,start_state,target_condition,invariant);
+    
+    printf("Portfolio member %zu: -b %d -e %d -m %d -q %d -z %u\n",i,ctx->cfg.oblig_prior_stack,ctx->cfg.resched,ctx->cfg.minimize,ctx->cfg.quick_reason,ctx->rng_seed);
+  }
+  
+  printf("\n--- Starting PDR portfolio --- \n");
+  fflush(stdout);
+  
+  running_portfolio = &portfolio;
+  {
+    WorkerPool pool(size);
+    pool.run(portfolioJob,&members[0]);
+  }
+  
+  if (portfolio.interrupted) {
+    printf("*** INTERRUPTED ***\n");
+    for (size_t i = 0; i < size; i++) {
+      FILE* output = members[i]->output;
+      printf("\nPortfolio member %zu:\n",i);
+      members[i]->output = stdout; // the destructor writes the final statistics there instead
+      delete members[i];
+      fclose(output);
+    }
+#ifdef PDR_TRACE
+    gtrace.close();
+#endif
+    fflush(stdout);
+    _exit(1);
+  }
+  running_portfolio = 0;
+  
+  printf("Portfolio member %d answered first.\n",portfolio.winner);
+  
+  // the destructors write the final statistics
+  for (size_t i = 0; i < size; i++) {
+    FILE* output = members[i]->output;
+    delete members[i];
+    
+    if ((int)i == portfolio.winner) {
+      char buf[4096];
+      size_t len;
+      rewind(output);
+      while ((len = fread(buf,1,sizeof(buf),output)) > 0)
+        fwrite(buf,1,len,stdout);
+    }
+    fclose(output);
+  }
+  
+  delete portfolio.exchange;
+}
+
 void normalizeActions() { // "first delete then add" is the official semantics!
   vector<int> playground;
   playground.resize(gnum_relevant_facts,0);
@@ -1638,20 +3223,41 @@ void normalizeActions() { // "first delete then add" is the official semantics!
 
 int main(int argc, char** argv)
 {
+  uint64_t grounding_start = nowNanos();
   main_orig(argc,argv); 
-
-  normalizeActions();    
+  
+  // the translations need the grounder's own data, so they always ground
+  bool use_cache = gcmd_line.task_cache[0] && !gcmd_line.just_translate && !gcmd_line.just_dumpgrounded;
+  char ops_file[MAX_LENGTH];
+  char fct_file[MAX_LENGTH];
+  snprintf(ops_file,MAX_LENGTH,"%s%s",gcmd_line.path,gcmd_line.ops_file_name);
+  snprintf(fct_file,MAX_LENGTH,"%s%s",gcmd_line.path,gcmd_line.fct_file_name);
+  
+  CachedTask task;
+  bool from_cache = use_cache && cache_Load(gcmd_line.task_cache,ops_file,fct_file,task);
+  if (from_cache) {
+    printf("Loaded %d facts and %d actions from the task cache %s in %fs.\n",gnum_relevant_facts,gnum_actions,gcmd_line.task_cache,(nowNanos() - grounding_start)*1e-9);
+  } else {
+    main_orig_ground();
+    
+    normalizeActions();    
+    buildActionTable();
+    printf("Parsing and grounding took %fs.\n",(nowNanos() - grounding_start)*1e-9);
+    
+    task.init.assign(ginitial_state.F,ginitial_state.F+ginitial_state.num_F);
+    task.goal.assign(ggoal_state.F,ggoal_state.F+ggoal_state.num_F);
+  }
      
   BoolState initial_state, start_state;
   Clause target_condition; // abusing clause structure, imposing conjunctive semantics
   
   initial_state.resize(gnum_relevant_facts,false);
-  for (int i = 0; i < ginitial_state.num_F; i++ ) 
-    initial_state[ginitial_state.F[i]] = true;
+  for (size_t i = 0; i < task.init.size(); i++ ) 
+    initial_state[task.init[i]] = true;
       
   bool sat_in_initial = true;
-  for (int i = 0; i < ggoal_state.num_F; i++ )
-    if (!initial_state[ggoal_state.F[i]]) {
+  for (size_t i = 0; i < task.goal.size(); i++ )
+    if (!initial_state[task.goal[i]]) {
       sat_in_initial = false;
       break;
     }
@@ -1665,13 +3271,13 @@ int main(int argc, char** argv)
   if (!gcmd_line.reverse) {
     start_state = initial_state;
                     
-    for (int i = 0; i < ggoal_state.num_F; i++ )
-      target_condition.push_back(ggoal_state.F[i]);      
+    for (size_t i = 0; i < task.goal.size(); i++ )
+      target_condition.push_back(task.goal[i]);      
   } else {
     // reverse has start_state with goal instead of init and flipped polarity
     start_state.resize(gnum_relevant_facts,true);
-    for (int i = 0; i < ggoal_state.num_F; i++) 
-      start_state[ggoal_state.F[i]] = false;
+    for (size_t i = 0; i < task.goal.size(); i++) 
+      start_state[task.goal[i]] = false;
                  
     //in target_condition are unit clauses corresponding to false initial lits    
     for (size_t i = 0; i < initial_state.size(); i++ ) 
@@ -1698,70 +3304,108 @@ int main(int argc, char** argv)
   // register the handler
   signal(SIGINT, SIGINT_exit);
   
-  // initilize context
-  {
-    Clause temp_clause;
-    context.layers_delta.push_back(Clauses());    
-    Clauses& target_layer = context.layers_delta[0];     
-    
-    //signature
-    context.sigsize = gnum_relevant_facts;
-    
-    //start
-    context.start_state = start_state;       
-    
-    //goal - putting into layers and also into goal_lits for fast random access with induction
-    context.goal_lits.resize(gnum_relevant_facts,false);    
+  // invariant (shared by all the contexts of a portfolio)
+  BinClauseBuffer invariant;
+  bool new_invariant = false;
+  if (gcmd_line.gen_invariant && from_cache && task.has_invariant && task.invariant_reversed == (bool)gcmd_line.reverse) {
+    for (size_t i = 0; i < task.invariant.size(); i++)
+      invariant.pushClause(task.invariant[i]);
+    printf("\nInvariant of %zu clauses taken from the task cache.\n\n",task.invariant.size());
+  } else if (gcmd_line.gen_invariant) {
+    printf("\nGenerating invariant ...\n");
+  
+    uint64_t start = nowNanos();
+    invariant_Init(target_condition);
+    double time_invariant = (nowNanos() - start)*1e-9;
+           
+    size_t bincl = 0;
+    size_t unitcl = 0;
+    invariant.reserve(invariant_Size());           
+    task.invariant.clear();
     
-    for (size_t i = 0; i < target_condition.size(); i++ ) {
-      temp_clause.clear();
-      temp_clause.push_back(target_condition[i]);                
-      ClauseBox* clbox = new ClauseBox(temp_clause,0);     
-      target_layer.push_back(clbox->inc());    
+    while (invariant_CurrentValid()) {
+      BinClause bcl = invariant_Current();
+                    
+      if (bcl.l1 == bcl.l2)
+        unitcl++;
+      else 
+        bincl++;
+      invariant.pushClause(bcl);         
+      if (use_cache)
+        task.invariant.push_back(bcl);
+
+      /*
+      print_ft_name(bcl.l1);
+      if (bcl.l1 != bcl.l2) {
+        printf(" ");
+        print_ft_name(bcl.l2);
+      }
+      printf("\n");          
+      */
       
-      if (gcmd_line.minimize > 1)
-        context.goal_lits[target_condition[i]] = true;       
+      invariant_Next();
     }
+    invariant_Done();
+     
+    printf("\tderived %zu binclauses and %zu units,\n",bincl,unitcl);
+    printf("\ttook %fs.\n\n",time_invariant);
     
-    // invariant
-    if (gcmd_line.gen_invariant) {
-      float time_invariant = 0.0;
-      printf("\nGenerating invariant ...\n");
-    
-      times(&start);
-      invariant_Init(target_condition);
-      times(&end);
-      TIME( time_invariant );
-             
-      size_t bincl = 0;
-      size_t unitcl = 0;
-      context.invariant.reserve(invariant_Size());           
-      
-      while (invariant_CurrentValid()) {
-        BinClause bcl = invariant_Current();
-                      
-        if (bcl.l1 == bcl.l2)
-          unitcl++;
-        else 
-          bincl++;
-        context.invariant.pushClause(bcl);         
-
-        /*
-        print_ft_name(bcl.l1);
-        if (bcl.l1 != bcl.l2) {
-          printf(" ");
-          print_ft_name(bcl.l2);
-        }
-        printf("\n");          
-        */
-        
-        invariant_Next();
-      }
-      invariant_Done();
-       
-      printf("\tderived %zu binclauses and %zu units,\n",bincl,unitcl);
-      printf("\ttook %fs.\n\n",time_invariant);
+    task.has_invariant = true;
+    task.invariant_reversed = gcmd_line.reverse;
+    new_invariant = true;
+  }
+  
+  // also after a hit, if the cache had no invariant for this direction
+  if (use_cache && (!from_cache || new_invariant)) {
+    if (cache_Write(gcmd_line.task_cache,ops_file,fct_file,task))
+      printf("Wrote the task cache %s.\n",gcmd_line.task_cache);
+    else
+      printf("Cannot write the task cache %s: %s\n",gcmd_line.task_cache,strerror(errno));
+  }
+  invariant.buildOccurrences(gnum_relevant_facts);
+  
+  // the statistics stream (shared by all the contexts of a portfolio); it is flushed after every record and left to exit to close
+  FILE* stats_stream = 0;
+  if (gcmd_line.stats_file[0]) {
+    stats_stream = fopen(gcmd_line.stats_file,"w");
+    if (!stats_stream) {
+      printf("Cannot open the statistics stream %s: %s\n",gcmd_line.stats_file,strerror(errno));
+      exit(1);
+    }
+  }
+  
+  if (gcmd_line.trace_file[0]) {
+#ifdef PDR_TRACE
+    if (!gtrace.open(gcmd_line.trace_file,gcmd_line.trace_sample)) {
+      printf("Cannot open the trace %s: %s\n",gcmd_line.trace_file,strerror(errno));
+      exit(1);
     }
+#else
+    printf("Tracing is not compiled in (build with CPPADDONS=-DPDR_TRACE), -T ignored.\n");
+#endif
+  }
+  
+  if (gcmd_line.portfolio > 1) {
+    runPortfolio(gcmd_line.portfolio,start_state,target_condition,invariant,stats_stream);
+#ifdef PDR_TRACE
+    gtrace.close();
+#endif
+    
+    fflush(stdout);
+    _exit(0);
+  }
+  
+  context.cfg = gcmd_line;
+  context.stats_stream = stats_stream;
+#ifdef PDR_TRACE
+  if (gtrace.active())
+    context.trace = &gtrace;
+#endif
+  context.seedRandom(gcmd_line.seed);
+  initContext(context,start_state,target_condition,invariant);
+  if (gcmd_line.replay_file[0] && !context.openReplayLog(gcmd_line.replay_file,gcmd_line.replay)) {
+    fflush(stdout);
+    _exit(1);
   }
   
   printf("\n--- Starting PDR --- \n");
@@ -1770,3 +3414,4 @@ int main(int argc, char** argv)
   
   return 0;
 }
+#endif
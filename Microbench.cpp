@@ -0,0 +1,318 @@
+/***********************************************************************************************
+Copyright (c) 2013, Martin Suda
+Max-Planck-Institut für Informatik, Saarbrücken, Germany
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**************************************************************************************************/
+
+/*
+ Microbenchmarks of the hot kernels of the search, on synthetic data (no PDDL is parsed):
+ clause evaluation, subsumption, pruning a layer by a new clause, the reason union and minimization
+ at the end of extend, and applying actions. Every kernel is swept over the signature size and the
+ number of clauses or actions; the data come from a fixed seed, so two builds measure the same work.
+
+ usage: microbench [<scale>]  (the number of operations per measurement is multiplied by scale, default 1)
+*/
+
+#define PDR_NO_MAIN
+#include "Main.cpp"
+
+static unsigned bench_seed = 1;
+static double   bench_scale = 1.0;
+static FILE*    bench_null;       // for the statistics the contexts print when destroyed
+
+static volatile size_t sink;      // keeps the results of the kernels alive
+
+static const size_t sigsizes[] = { 256, 1024, 4096 };
+static const size_t num_sigsizes = sizeof(sigsizes)/sizeof(sigsizes[0]);
+
+static const size_t counts[] = { 1000, 10000 };
+static const size_t num_counts = sizeof(counts)/sizeof(counts[0]);
+
+static size_t randomBelow(size_t n) {
+  return (size_t)rand_r(&bench_seed) % n;
+}
+
+static void randomShuffle(Clause& cl) {
+  for (size_t i = cl.size(); i > 1; i--)
+    swap(cl[i-1],cl[randomBelow(i)]);
+}
+
+// len distinct literals, sorted
+static void randomClause(size_t sigsize, size_t len, Clause& cl) {
+  cl.clear();
+  while (cl.size() < len) {
+    size_t lit = randomBelow(sigsize);
+    if (find(cl.begin(),cl.end(),lit) == cl.end())
+      cl.push_back(lit);
+  }
+  sort(cl.begin(),cl.end());
+}
+
+static void randomState(size_t sigsize, size_t percent_true, BoolState& st) {
+  st.resize(sigsize);
+  st.fill(false);
+  for (size_t i = 0; i < sigsize; i++)
+    if (randomBelow(100) < percent_true)
+      st.set(i);
+}
+
+// num_actions actions with 3 preconditions, 2 adds and 2 dels each, as the action table (and gnum_actions) of the whole program
+static void syntheticActions(size_t sigsize, size_t num_actions) {
+  ActionTable &t = gaction_table;
+  Clause lits;
+
+  t.pre_start.assign(1,0);
+  t.add_start.assign(1,0);
+  t.del_start.assign(1,0);
+  t.pre_lits.clear();
+  t.add_lits.clear();
+  t.del_lits.clear();
+  t.reversed = false;
+
+  for (size_t a = 0; a < num_actions; a++) {
+    randomClause(sigsize,7,lits);
+    randomShuffle(lits);
+    t.pre_lits.insert(t.pre_lits.end(),lits.begin(),lits.begin()+3);
+    t.pre_start.push_back(t.pre_lits.size());
+    t.add_lits.insert(t.add_lits.end(),lits.begin()+3,lits.begin()+5);
+    t.add_start.push_back(t.add_lits.size());
+    t.del_lits.insert(t.del_lits.end(),lits.begin()+5,lits.end());
+    t.del_start.push_back(t.del_lits.size());
+  }
+
+  gnum_actions = (int)num_actions;
+  gnum_relevant_facts = (int)sigsize;
+  buildAdderIndex(sigsize);
+}
+
+// an empty context over sigsize atoms, with layers 0 and 1
+static SolvingContext* syntheticContext(size_t sigsize) {
+  SolvingContext* ctx = new SolvingContext;
+  ctx->cfg = gcmd_line;
+  ctx->output = bench_null;
+  ctx->sigsize = sigsize;
+  ctx->clause_index.resize(sigsize);
+  ctx->layers_delta.resize(2);
+  ctx->layers_deriv.resize(2);
+  ctx->goal_lits.resize(sigsize,false);
+  return ctx;
+}
+
+static size_t numOps(size_t base) {
+  size_t ops = (size_t)(base*bench_scale);
+  return ops ? ops : 1;
+}
+
+static void report(const char* kernel, size_t sigsize, size_t count, double secs, size_t ops) {
+  printf("%-24s %8zu %8zu %12.1f\n",kernel,sigsize,count,secs*1e9/ops);
+  fflush(stdout);
+}
+
+// count clauses evaluated in random states, literal by literal and word-packed
+static void benchClauseUnsatisfied(size_t sigsize, size_t count) {
+  vector<Clause> clauses(count);
+  vector<PackedClause> packed(count);
+  for (size_t i = 0; i < count; i++) {
+    randomClause(sigsize,8,clauses[i]);
+    packClause(clauses[i],packed[i]);
+  }
+  vector<BoolState> states(16);
+  for (size_t i = 0; i < states.size(); i++)
+    randomState(sigsize,10,states[i]); // sparse, so that a fair share of the clauses is false
+
+  size_t rounds = numOps(4000000)/count + 1;
+  size_t hits = 0;
+  double t0 = nowNanos()*1e-9;
+  for (size_t r = 0; r < rounds; r++) {
+    BoolState const& st = states[r % states.size()];
+    for (size_t i = 0; i < count; i++)
+      hits += clauseUnsatisfied(ClauseView(clauses[i]),st);
+  }
+  double t1 = nowNanos()*1e-9;
+  for (size_t r = 0; r < rounds; r++) {
+    BoolState const& st = states[r % states.size()];
+    for (size_t i = 0; i < count; i++)
+      hits += clauseUnsatisfied(PackedClauseView(packed[i]),st);
+  }
+  double t2 = nowNanos()*1e-9;
+  sink += hits;
+
+  report("clauseUnsatisfied",sigsize,count,t1-t0,rounds*count);
+  report("clauseUnsatisfied/pack",sigsize,count,t2-t1,rounds*count);
+}
+
+// short clauses against long ones, every other pair a real subsumption
+static void benchSubsumes(size_t sigsize, size_t count) {
+  vector<Clause> shorts(count), longs(count);
+  for (size_t i = 0; i < count; i++) {
+    randomClause(sigsize,12,longs[i]);
+    if (i % 2) {
+      shorts[i].assign(longs[i].begin(),longs[i].end());
+      randomShuffle(shorts[i]);
+      shorts[i].resize(4);
+      sort(shorts[i].begin(),shorts[i].end());
+    } else
+      randomClause(sigsize,4,shorts[i]);
+  }
+
+  size_t rounds = numOps(4000000)/count + 1;
+  size_t hits = 0;
+  double t0 = nowNanos()*1e-9;
+  for (size_t r = 0; r < rounds; r++)
+    for (size_t i = 0; i < count; i++)
+      hits += subsumes(shorts[i],longs[(i + r) % count]) + subsumes(shorts[i],longs[i]);
+  double t1 = nowNanos()*1e-9;
+  sink += hits;
+
+  report("subsumes",sigsize,count,t1-t0,2*rounds*count);
+}
+
+// new clauses checked against a layer of count clauses (through the occurrence and watch lists)
+static void benchPruneLayer(size_t sigsize, size_t count) {
+  SolvingContext* ctx = syntheticContext(sigsize);
+  Clause cl;
+  for (size_t i = 0; i < count; i++) {
+    randomClause(sigsize,2 + randomBelow(10),cl);
+    ClauseBox* clbox = ClauseBox::create(ctx->clause_pool,cl,1);
+    ctx->layers_delta[1].push_back(clbox->inc());
+    ctx->clause_index.insert(clbox);
+  }
+
+  vector<Clause> queries(1024);
+  for (size_t i = 0; i < queries.size(); i++)
+    randomClause(sigsize,4 + randomBelow(8),queries[i]);
+
+  size_t ops = numOps(200000);
+  size_t kept = 0;
+  ClauseBox* same;
+  double t0 = nowNanos()*1e-9;
+  for (size_t i = 0; i < ops; i++)
+    kept += ctx->pruneLayerByClause(queries[i % queries.size()],ctx->layers_delta[1],1,true,same);
+  double t1 = nowNanos()*1e-9;
+  sink += kept;
+
+  report("pruneLayerByClause",sigsize,count,t1-t0,ops);
+  delete ctx;
+}
+
+/*
+ the end of a failed extend: count/4 buffers of 1 to 4 reasons each (the last one standing for the no-op),
+ the union of the reasons and then its minimization as with -m 1 and -m 3
+*/
+static void benchReasons(size_t sigsize, size_t count) {
+  syntheticActions(sigsize,count);
+  SolvingContext* ctx = syntheticContext(sigsize);
+  ctx->seedRandom(1);
+
+  size_t num_buffers = count/4;
+  ctx->buffers.resize(num_buffers);
+  ctx->used_buffer_size = num_buffers;
+  ctx->action_interesting.assign(count,0);
+  Clause cl;
+  for (size_t b = 0; b < num_buffers; b++) {
+    ClauseBuffer & buffer = ctx->buffers[b];
+    buffer.clear();
+    buffer.action = (b+1 < num_buffers) ? b : NO_ACTION;
+    if (b+1 < num_buffers)
+      ctx->action_interesting[b] = 1;
+
+    size_t num = 1 + randomBelow(4);
+    for (size_t i = 0; i < num; i++) {
+      randomClause(sigsize,2 + randomBelow(6),cl);
+      buffer.num_clauses++;
+      buffer.clauses.push_back(cl.size());
+      buffer.clauses.insert(buffer.clauses.end(),cl.begin(),cl.end());
+    }
+  }
+  BoolState goal;
+  randomState(sigsize,5,goal); // only used with -m 3
+
+  size_t ops = numOps(20000000)/(num_buffers*sigsize/64) + 1;
+  double t0 = nowNanos()*1e-9;
+  for (size_t i = 0; i < ops; i++)
+    ctx->unionReasons();
+  double t1 = nowNanos()*1e-9;
+  report("unionReasons",sigsize,count,t1-t0,ops);
+
+  int levels[] = { 1, 3 };
+  for (size_t l = 0; l < 2; l++) {
+    ctx->cfg.minimize = levels[l];
+    if (levels[l] > 1)
+      ctx->goal_lits = goal;
+    size_t ops_min = ops/8 + 1;
+    double t2 = nowNanos()*1e-9;
+    for (size_t i = 0; i < ops_min; i++) {
+      ctx->unionReasons();
+      ctx->minimizeReason();
+    }
+    double t3 = nowNanos()*1e-9;
+    report(levels[l] == 1 ? "union+minimize (-m 1)" : "union+minimize (-m 3)",sigsize,count,t3-t2,ops_min);
+  }
+
+  delete ctx;
+}
+
+// random applicable or not, the effects are applied regardless (as in oblState)
+static void benchApplyActionEffects(size_t sigsize, size_t count) {
+  syntheticActions(sigsize,count);
+  BoolState st;
+  randomState(sigsize,50,st);
+
+  size_t ops = numOps(20000000);
+  size_t applicable = 0;
+  double t0 = nowNanos()*1e-9;
+  for (size_t i = 0; i < ops; i++) {
+    size_t a = (i * 7919) % count;
+    applicable += actionApplicable(st,a);
+    applyActionEffects(st,a);
+  }
+  double t1 = nowNanos()*1e-9;
+  sink += applicable;
+
+  report("applyActionEffects",sigsize,count,t1-t0,ops);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1 && sscanf(argv[1],"%lf",&bench_scale) != 1) {
+    printf("usage: microbench [<scale>]\n");
+    return 1;
+  }
+
+  bench_null = fopen("/dev/null","w");
+  if (!bench_null) {
+    printf("%s\n",strerror(errno));
+    return 1;
+  }
+  context.output = bench_null;
+
+  gcmd_line.minimize = 3;
+  gcmd_line.obl_subsumption = 1;
+
+  printf("%-24s %8s %8s %12s\n","kernel","sigsize","count","ns/op");
+
+  for (size_t s = 0; s < num_sigsizes; s++)
+    for (size_t c = 0; c < num_counts; c++) {
+      benchClauseUnsatisfied(sigsizes[s],counts[c]);
+      benchSubsumes(sigsizes[s],counts[c]);
+      benchPruneLayer(sigsizes[s],counts[c]);
+      benchReasons(sigsizes[s],counts[c]);
+      benchApplyActionEffects(sigsizes[s],counts[c]);
+    }
+
+  return 0;
+}
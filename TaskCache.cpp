@@ -0,0 +1,382 @@
+/***********************************************************************************************
+Copyright (c) 2013, Martin Suda
+Max-Planck-Institut für Informatik, Saarbrücken, Germany
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**************************************************************************************************/
+
+#include "TaskCache.h"
+
+#include "bb.h"
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static const char CACHE_MAGIC[8] = { 'P','D','R','T','A','S','K','2' };
+
+static const uint64_t INV_PRESENT  = 1;
+static const uint64_t INV_REVERSED = 2;
+
+// The file starts with the header, followed by the sections
+//   pre_start, add_start, del_start (num_actions+1 uint64_t each), pre_lits, add_lits, del_lits, init, goal (int32_t),
+//   the invariant (pairs of int32_t), fact name offsets (num_facts+1 uint64_t), fact names (NUL-terminated),
+//   action name offsets (num_actions+1 uint64_t), action names (NUL-terminated),
+// each one padded to a multiple of 8 bytes.
+// a file the task was grounded from; the hash of the contents tells apart e.g. two instances with the same size and time stamp
+struct FileStamp {
+  uint64_t size;
+  uint64_t mtime_sec, mtime_nsec;
+  uint64_t hash;                   // 64-bit FNV-1a
+};
+
+struct CacheHeader {
+  char      magic[8];
+  FileStamp ops, fct;
+  uint64_t num_facts, num_actions;
+  uint64_t num_pres, num_adds, num_dels;
+  uint64_t num_init, num_goal;
+  uint64_t num_invariant;          // clauses
+  uint64_t invariant_flags;
+  uint64_t fact_name_bytes, action_name_bytes;
+};
+
+static bool fileStamp(const char* name, FileStamp& stamp) {
+  struct stat st;
+  if (stat(name,&st))
+    return false;
+  stamp.size = st.st_size;
+  stamp.mtime_sec = st.st_mtim.tv_sec;
+  stamp.mtime_nsec = st.st_mtim.tv_nsec;
+  
+  FILE* in = fopen(name,"rb");
+  if (!in)
+    return false;
+  uint64_t hash = 14695981039346656037ULL;
+  unsigned char buf[65536];
+  size_t len;
+  while ((len = fread(buf,1,sizeof(buf),in)) > 0)
+    for (size_t i = 0; i < len; i++)
+      hash = (hash ^ buf[i]) * 1099511628211ULL;
+  bool ok = !ferror(in);
+  fclose(in);
+  stamp.hash = hash;
+  return ok;
+}
+
+static bool sameStamp(FileStamp const& a, FileStamp const& b) {
+  return a.size == b.size && a.mtime_sec == b.mtime_sec && a.mtime_nsec == b.mtime_nsec && a.hash == b.hash;
+}
+
+namespace {
+
+struct CacheWriter {
+  FILE* out;
+  uint64_t pos;
+  bool ok;
+
+  CacheWriter(FILE* f) : out(f), pos(0), ok(true) {}
+
+  void write(const void* data, size_t bytes) {
+    if (bytes && fwrite(data,1,bytes,out) != bytes)
+      ok = false;
+    pos += bytes;
+  }
+
+  void pad() {
+    static const char zeros[8] = { 0 };
+    if (pos % 8)
+      write(zeros,8 - pos % 8);
+  }
+
+  template<class T, class S>
+  void section(vector<S> const& v) {
+    vector<T> conv(v.begin(),v.end());
+    if (!conv.empty())
+      write(&conv[0],conv.size()*sizeof(T));
+    pad();
+  }
+};
+
+struct CacheReader {
+  const char* base;
+  size_t size;
+  size_t pos;
+  bool ok;
+
+  CacheReader(const char* b, size_t s) : base(b), size(s), pos(0), ok(true) {}
+
+  template<class T>
+  const T* section(uint64_t n) {
+    if (!ok || n > (size - pos) / sizeof(T)) {
+      ok = false;
+      return 0;
+    }
+    const T* res = (const T*)(base + pos);
+    pos += n*sizeof(T);
+    pos = std::min(size,(pos + 7) & ~(size_t)7);
+    return res;
+  }
+};
+
+}
+
+// the names are consecutive NUL-terminated strings: their offsets must start at 0, increase up to the end of the block
+// and every name end with a NUL just before the next one starts
+static bool namesConsistent(const uint64_t* offsets, uint64_t num, const char* names, uint64_t bytes) {
+  if (offsets[0] != 0 || offsets[num] != bytes)
+    return false;
+  for (uint64_t i = 0; i < num; i++)
+    if (offsets[i] >= offsets[i+1] || names[offsets[i+1]-1])
+      return false;
+  return true;
+}
+
+static bool tableConsistent(const uint64_t* start, const int32_t* lits, uint64_t num_actions, uint64_t num_lits, uint64_t num_facts) {
+  if (start[0] != 0 || start[num_actions] != num_lits)
+    return false;
+  for (uint64_t a = 0; a < num_actions; a++)
+    if (start[a] > start[a+1])
+      return false;
+  for (uint64_t i = 0; i < num_lits; i++)
+    if (lits[i] < 0 || (uint64_t)lits[i] >= num_facts)
+      return false;
+  return true;
+}
+
+static bool litsConsistent(const int32_t* lits, uint64_t num, uint64_t num_facts) {
+  for (uint64_t i = 0; i < num; i++)
+    if (lits[i] < 0 || (uint64_t)lits[i] >= num_facts)
+      return false;
+  return true;
+}
+
+bool cache_Load(const char* file, const char* ops_file, const char* fct_file, CachedTask& task) {
+  FileStamp ops, fct;
+  if (!fileStamp(ops_file,ops) || !fileStamp(fct_file,fct))
+    return false;
+  
+  int fd = open(file,O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd,&st) || (size_t)st.st_size < sizeof(CacheHeader)) {
+    close(fd);
+    return false;
+  }
+  void* map = mmap(0,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+  
+  CacheReader r((const char*)map,st.st_size);
+  const CacheHeader* h = r.section<CacheHeader>(1);
+  if (memcmp(h->magic,CACHE_MAGIC,sizeof(CACHE_MAGIC)) || !sameStamp(h->ops,ops) || !sameStamp(h->fct,fct)) {
+    munmap(map,st.st_size);
+    return false;
+  }
+  
+  uint64_t nf = h->num_facts;
+  uint64_t na = h->num_actions;
+  const uint64_t* pre_start = r.section<uint64_t>(na+1);
+  const uint64_t* add_start = r.section<uint64_t>(na+1);
+  const uint64_t* del_start = r.section<uint64_t>(na+1);
+  const int32_t* pre_lits = r.section<int32_t>(h->num_pres);
+  const int32_t* add_lits = r.section<int32_t>(h->num_adds);
+  const int32_t* del_lits = r.section<int32_t>(h->num_dels);
+  const int32_t* init = r.section<int32_t>(h->num_init);
+  const int32_t* goal = r.section<int32_t>(h->num_goal);
+  const int32_t* inv = r.section<int32_t>(2*h->num_invariant);
+  const uint64_t* fact_name_start = r.section<uint64_t>(nf+1);
+  const char* fact_names = r.section<char>(h->fact_name_bytes);
+  const uint64_t* action_name_start = r.section<uint64_t>(na+1);
+  const char* action_names = r.section<char>(h->action_name_bytes);
+  
+  if (!r.ok ||
+      !tableConsistent(pre_start,pre_lits,na,h->num_pres,nf) ||
+      !tableConsistent(add_start,add_lits,na,h->num_adds,nf) ||
+      !tableConsistent(del_start,del_lits,na,h->num_dels,nf) ||
+      !litsConsistent(init,h->num_init,nf) || !litsConsistent(goal,h->num_goal,nf) || !litsConsistent(inv,2*h->num_invariant,nf) ||
+      !namesConsistent(fact_name_start,nf,fact_names,h->fact_name_bytes) ||
+      !namesConsistent(action_name_start,na,action_names,h->action_name_bytes)) {
+    printf("Task cache %s is corrupt.\n",file);
+    munmap(map,st.st_size);
+    return false;
+  }
+  
+  ActionTable &t = gaction_table;
+  t.pre_start.assign(pre_start,pre_start+na+1);
+  t.add_start.assign(add_start,add_start+na+1);
+  t.del_start.assign(del_start,del_start+na+1);
+  t.pre_lits.assign(pre_lits,pre_lits+h->num_pres);
+  t.add_lits.assign(add_lits,add_lits+h->num_adds);
+  t.del_lits.assign(del_lits,del_lits+h->num_dels);
+  t.reversed = false;
+  t.op.clear();
+  t.inst_start.clear();
+  t.inst.clear();
+  
+  // the names stay in the mapping, which is never unmapped
+  t.names.resize(na);
+  for (uint64_t a = 0; a < na; a++)
+    t.names[a] = action_names + action_name_start[a];
+  gfact_names.resize(nf);
+  for (uint64_t i = 0; i < nf; i++)
+    gfact_names[i] = fact_names + fact_name_start[i];
+  
+  gnum_relevant_facts = (int)nf;
+  gnum_actions = (int)na;
+  
+  setActionDirection(gcmd_line.reverse);
+  buildAdderIndex(nf);
+  
+  task.init.assign(init,init+h->num_init);
+  task.goal.assign(goal,goal+h->num_goal);
+  task.has_invariant = h->invariant_flags & INV_PRESENT;
+  task.invariant_reversed = h->invariant_flags & INV_REVERSED;
+  task.invariant.resize(h->num_invariant);
+  for (uint64_t i = 0; i < h->num_invariant; i++) {
+    task.invariant[i].l1 = inv[2*i];
+    task.invariant[i].l2 = inv[2*i+1];
+  }
+  
+  return true;
+}
+
+// as printed by print_ft_name
+static void appendFactName(string& out, Fact const& f) {
+  if (f.predicate == -1) {
+    out += "=(";
+    out += gconstants[f.args[0]];
+    out += " ";
+    out += gconstants[f.args[1]];
+    out += ")";
+    return;
+  }
+  out += gpredicates[f.predicate];
+  out += "(";
+  for (int j = 0; j < garity[f.predicate]; j++) {
+    if (j)
+      out += " ";
+    out += gconstants[f.args[j]];
+  }
+  out += ")";
+}
+
+bool cache_Write(const char* file, const char* ops_file, const char* fct_file, CachedTask const& task) {
+  ActionTable &t = gaction_table;
+  
+  CacheHeader h;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,CACHE_MAGIC,sizeof(CACHE_MAGIC));
+  if (!fileStamp(ops_file,h.ops) || !fileStamp(fct_file,h.fct))
+    return false;
+  
+  // a task loaded from a cache has just the names (the grounder's tables are empty then)
+  vector<size_t> fact_name_start(1,0);
+  string fact_names;
+  for (int i = 0; i < gnum_relevant_facts; i++) {
+    if (gfact_names.empty())
+      appendFactName(fact_names,grelevant_facts[i]);
+    else
+      fact_names += gfact_names[i];
+    fact_names += '\0';
+    fact_name_start.push_back(fact_names.size());
+  }
+  
+  vector<size_t> action_name_start(1,0);
+  string action_names;
+  for (size_t a = 0; a+1 < t.pre_start.size(); a++) {
+    if (t.names.empty()) {
+      action_names += goperators[t.op[a]]->name;
+      for (size_t i = t.inst_start[a]; i < t.inst_start[a+1]; i++) {
+        action_names += " ";
+        action_names += gconstants[t.inst[i]];
+      }
+    } else
+      action_names += t.names[a];
+    action_names += '\0';
+    action_name_start.push_back(action_names.size());
+  }
+  
+  vector<int> inv;
+  for (size_t i = 0; i < task.invariant.size(); i++) {
+    inv.push_back(task.invariant[i].l1);
+    inv.push_back(task.invariant[i].l2);
+  }
+  
+  // stored in the forward direction
+  bool reversed = t.reversed;
+  setActionDirection(false);
+  
+  h.num_facts = gnum_relevant_facts;
+  h.num_actions = t.pre_start.size() - 1;
+  h.num_pres = t.pre_lits.size();
+  h.num_adds = t.add_lits.size();
+  h.num_dels = t.del_lits.size();
+  h.num_init = task.init.size();
+  h.num_goal = task.goal.size();
+  h.num_invariant = task.invariant.size();
+  h.invariant_flags = (task.has_invariant ? INV_PRESENT : 0) | (task.invariant_reversed ? INV_REVERSED : 0);
+  h.fact_name_bytes = fact_names.size();
+  h.action_name_bytes = action_names.size();
+  
+  // written aside and renamed, so that a concurrent run never sees it half-written
+  string tmp_name = string(file) + ".tmp";
+  char pid[32];
+  sprintf(pid,"%d",(int)getpid());
+  tmp_name += pid;
+  
+  FILE* out = fopen(tmp_name.c_str(),"wb");
+  if (!out) {
+    setActionDirection(reversed);
+    return false;
+  }
+  
+  CacheWriter w(out);
+  w.write(&h,sizeof(h));
+  w.pad();
+  w.section<uint64_t>(t.pre_start);
+  w.section<uint64_t>(t.add_start);
+  w.section<uint64_t>(t.del_start);
+  w.section<int32_t>(t.pre_lits);
+  w.section<int32_t>(t.add_lits);
+  w.section<int32_t>(t.del_lits);
+  w.section<int32_t>(task.init);
+  w.section<int32_t>(task.goal);
+  w.section<int32_t>(inv);
+  w.section<uint64_t>(fact_name_start);
+  w.section<char>(vector<char>(fact_names.begin(),fact_names.end()));
+  w.section<uint64_t>(action_name_start);
+  w.section<char>(vector<char>(action_names.begin(),action_names.end()));
+  
+  setActionDirection(reversed);
+  
+  if (fclose(out))
+    w.ok = false;
+  if (!w.ok || rename(tmp_name.c_str(),file)) {
+    unlink(tmp_name.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,56 @@
+/***********************************************************************************************
+Copyright (c) 2013, Martin Suda
+Max-Planck-Institut für Informatik, Saarbrücken, Germany
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**************************************************************************************************/
+
+#ifndef TaskCache_h
+#define TaskCache_h
+
+#include <vector>
+
+#include "Common.h"
+#include "Invariant.h"
+
+/*
+ * A task cache is a binary file with the grounded and normalized task: the names of the facts, the actions
+ * (in the forward direction) with their names, init, goal and, if it was computed, the invariant.
+ * It is loaded by mmap-ing it, so that the runs on one instance skip parsing and grounding
+ * and share the pages of the file. It is in the native byte order, not meant to be moved between machines.
+ */
+
+struct CachedTask {
+  std::vector<int> init;            // the facts true initially
+  std::vector<int> goal;            // the facts to reach
+  
+  bool has_invariant;
+  bool invariant_reversed;          // the value of gcmd_line.reverse the invariant was computed for
+  std::vector<BinClause> invariant;
+  
+  CachedTask() : has_invariant(false), invariant_reversed(false) {}
+};
+
+/* loads the task from the cache file; false if it's missing, unreadable, or was grounded from 
+   other versions of ops_file and fct_file (going by their sizes, modification times and a hash of their contents).
+   Sets up gaction_table (in the direction given by gcmd_line.reverse), gfact_names, gnum_relevant_facts and gnum_actions. */
+bool cache_Load(const char* file, const char* ops_file, const char* fct_file, CachedTask& task);
+
+/* writes the task grounded from ops_file and fct_file (gaction_table and grelevant_facts, or the names of a task loaded from a cache, plus task) to the cache file;
+   the file is replaced by a rename, so the mapping of a previous cache_Load stays valid */
+bool cache_Write(const char* file, const char* ops_file, const char* fct_file, CachedTask const& task);
+
+#endif
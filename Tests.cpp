@@ -0,0 +1,93 @@
+/***********************************************************************************************
+Copyright (c) 2013, Martin Suda
+Max-Planck-Institut für Informatik, Saarbrücken, Germany
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**************************************************************************************************/
+
+/*
+ Unit tests of the self-contained data structures (no PDDL is parsed).
+
+ usage: tests  (prints the failed checks; the exit status is the number of them)
+*/
+
+#include "Common.h"
+
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK(cond) if (!(cond)) { printf("%s:%d: check failed: %s\n",__FILE__,__LINE__,#cond); failures++; }
+
+// every bit of s as expected: [0,split) are lo, [split,size) hi
+static bool bitsAre(BoolState const& s, size_t split, bool lo, bool hi) {
+  for (size_t i = 0; i < s.size(); i++)
+    if (s[i] != (i < split ? lo : hi))
+      return false;
+  return true;
+}
+
+// the bits past size() must stay clear, numWords() tells
+static bool trimmed(BoolState const& s) {
+  return !s.numWords() || !(s.size() % STATE_WORD_BITS) || !(s.word(s.numWords()-1) >> (s.size() % STATE_WORD_BITS));
+}
+
+static void testBoolStateResize() {
+  // growing with true within the word that is already partially used keeps the old bits
+  BoolState s(3,false);
+  s.resize(5,true);
+  CHECK(s.size() == 5);
+  CHECK(bitsAre(s,3,false,true));
+  CHECK(trimmed(s));
+  
+  // the same across word boundaries
+  BoolState t(3,false);
+  t.set(1);
+  t.resize(3*STATE_WORD_BITS+7,true);
+  CHECK(!t[0] && t[1] && !t[2]);
+  for (size_t i = 3; i < t.size(); i++)
+    CHECK(t[i]);
+  CHECK(trimmed(t));
+  
+  // growing from a full word
+  BoolState u(STATE_WORD_BITS,false);
+  u.resize(STATE_WORD_BITS+1,true);
+  CHECK(bitsAre(u,STATE_WORD_BITS,false,true));
+  
+  // from empty, and growing with false
+  BoolState v;
+  v.resize(70,true);
+  CHECK(bitsAre(v,0,false,true) && trimmed(v));
+  v.resize(75);
+  CHECK(bitsAre(v,70,true,false) && trimmed(v));
+  
+  // shrinking clears the dropped bits, a later grow doesn't bring them back
+  v.resize(10);
+  CHECK(trimmed(v));
+  v.resize(20);
+  CHECK(bitsAre(v,10,true,false));
+}
+
+int main()
+{
+  testBoolStateResize();
+  
+  if (failures)
+    printf("%d checks failed.\n",failures);
+  else
+    printf("All checks passed.\n");
+  return failures;
+}
@@ -35,7 +35,7 @@ static int encodeActions(bool print, FILE* outfile) {
   int numcl = 0;
   int actvar = gnum_relevant_facts+1;
 
-  for (Action* a = gactions; a; a = a->next) { 
+  for (size_t a = 0; a < (size_t)gnum_actions; a++) { 
     // preconds    
     for (int i = 0; i < numPreconds(a); i++) {
       if (print) {
@@ -63,7 +63,7 @@ static int encodeActions(bool print, FILE* outfile) {
   return numcl;
 }
 
-static bool actionPreservesFact(Action* a, int fact) {
+static bool actionPreservesFact(size_t a, int fact) {
   for (int i = 0; i < numAdds(a); i++)
     if (getAdd(a,i) == fact)
       return false;
@@ -93,7 +93,7 @@ static int sequentialEncoding(bool print, FILE* outfile) {
   
   // classical frame   
   actvar = gnum_relevant_facts+1;
-  for (Action* a = gactions; a; a = a->next) {          
+  for (size_t a = 0; a < (size_t)gnum_actions; a++) {          
     for (int i = 0; i < gnum_relevant_facts; i++)
       if (actionPreservesFact(a,i)) {
         if (print) {
@@ -108,7 +108,7 @@ static int sequentialEncoding(bool print, FILE* outfile) {
   return numcl;
 }
 
-static bool actionDeletesPreOrAdd(Action *a, Action *b) {
+static bool actionDeletesPreOrAdd(size_t a, size_t b) {
   for (int i = 0; i < numDels(a); i++) {
     for (int j = 0; j < numPreconds(b); j++)
       if (getDel(a,i) == getPrecond(b,j))
@@ -127,9 +127,9 @@ static int parallelEncoding(bool print, FILE* outfile) {
    
   // at most one (mutex)
   int actvara = gnum_relevant_facts+1;
-  for (Action* a = gactions; a; a = a->next) {
+  for (size_t a = 0; a < (size_t)gnum_actions; a++) {
     int actvarb = actvara+1;
-    for (Action* b = a->next; b; b = b->next) {
+    for (size_t b = a+1; b < (size_t)gnum_actions; b++) {
       if (actionDeletesPreOrAdd(a,b) || actionDeletesPreOrAdd(b,a)) {
         if (print)
           fprintf(outfile,"%d %d 0\n",-actvara,-actvarb);        
@@ -150,7 +150,7 @@ static int parallelEncoding(bool print, FILE* outfile) {
       // added
       fprintf(outfile,"%d %d ",(i+1),-(gnum_relevant_facts+gnum_actions+i+1));
       actvar = gnum_relevant_facts+1;
-      for (Action* a = gactions; a; a = a->next) {
+      for (size_t a = 0; a < (size_t)gnum_actions; a++) {
         for (int j = 0; j < numAdds(a); j++)
           if (getAdd(a,j) == i) {
             fprintf(outfile,"%d ",actvar);
@@ -164,7 +164,7 @@ static int parallelEncoding(bool print, FILE* outfile) {
       // deleted
       fprintf(outfile,"%d %d ",-(i+1),(gnum_relevant_facts+gnum_actions+i+1));
       actvar = gnum_relevant_facts+1;
-      for (Action* a = gactions; a; a = a->next) {
+      for (size_t a = 0; a < (size_t)gnum_actions; a++) {
         for (int j = 0; j < numDels(a); j++)
           if (getDel(a,j) == i) {
             fprintf(outfile,"%d ",actvar);
@@ -189,7 +189,7 @@ void translate_Translate(FILE* outfile, BoolState& start_state, Clause& target_c
     fprintf(outfile,"\n");
   }
 
-  for (Action* a = gactions; a; a = a->next) { 
+  for (size_t a = 0; a < (size_t)gnum_actions; a++) { 
     fprintf(outfile,"c ACTION %d ", varidx++ +1);
     printAction(outfile,a);
   }    
@@ -223,6 +223,7 @@ void translate_Translate(FILE* outfile, BoolState& start_state, Clause& target_c
     bool extra_flip; 
     if ((extra_flip = !gcmd_line.reverse)) {// assiment intended!
       gcmd_line.reverse = 1; // will force forward invariant computation 
+      setActionDirection(true);
 
       // hack the (already above properly used) target condition to the clauses false in the initial state
       target_condition.clear();
@@ -272,7 +273,7 @@ void translate_DumpGrounded(BoolState& start_state, Clause& target_condition) {
   }
   fprintf(out_file,")\n");    
 
-  for (Action* a = gactions; a; a = a->next) {
+  for (size_t a = 0; a < (size_t)gnum_actions; a++) {
     fprintf(out_file,"(:action ");
     printGroundedAction(out_file,a);
     
@@ -165,28 +165,21 @@ extern "C"
 
 
 
-#define MAX_CONSTANTS 2500    /* MS: increased from 2000 */
-#define MAX_PREDICATES 4400   /* MS: increased from 2400 */
 #define MAX_TYPES 50
 #define MAX_ARITY 5
 #define MAX_VARS 15
 
 
-#define MAX_TYPE 2500         /* MS: increased from 2000 */
-
-
-#define MAX_INITIAL 100000     /* MS: increased from 5000 */
-
-
-#define MAX_OPERATORS 105000  /* MS: increased from 12800 */
+/* the tables of constants (and the constants of each type), predicates,
+ * operators, initial, goal and relevant facts have no limit:
+ * they start with this many entries and double when full
+ */
+#define INITIAL_TABLE_SIZE 64
 
 
 #define MAX_TYPE_INTERSECTIONS 10
 
 
-#define MAX_RELEVANT_FACTS 100000 /* i think this is VERY generous... */ /* MS: increased from 10000*/
-
-
 
 
 
@@ -215,9 +208,6 @@ extern "C"
 #define MAX_PLAN_LENGTH 2000
 
 
-#define MAX_STATE 10000 /*MS: increased from 6400*/
-
-
 #define MAX_SPACE 150000
 
 
@@ -393,6 +383,22 @@ struct _command_line {
   int resched;
   
   int postprocess;
+  
+  int threads;
+  
+  int portfolio;
+  int share_clauses;
+  
+  unsigned int seed;
+  char replay_file[MAX_LENGTH];
+  int replay;  /* replay_file is read (1) rather than written (0) */
+  
+  char stats_file[MAX_LENGTH];
+  
+  char trace_file[MAX_LENGTH];
+  int trace_sample;
+  
+  char task_cache[MAX_LENGTH];
 };
 
 typedef char *Token;
@@ -605,18 +611,19 @@ typedef struct _ActionTemplate {
 
 
 
-/* an instantiated operator
+/* an instantiated operator;
+ * the fact arrays are sized by new_Action to the operator's counts
  */
 typedef struct _Action {
 
   int op;
   int inst_table[MAX_VARS];
 
-  int preconds[MAX_OP_P];
+  int *preconds;
   int num_preconds;
-  int adds[MAX_OP_A];
+  int *adds;
   int num_adds;
-  int dels[MAX_OP_D];
+  int *dels;
   int num_dels;
 
   struct _Action *next;
@@ -912,7 +919,7 @@ typedef struct _IntBitVectorList {
 
 typedef struct _State {
   
-  int F[MAX_STATE];
+  int *F;
   int num_F;
 
 } State;
@@ -993,6 +1000,7 @@ Bool process_command_line( int argc, char *argv[] );
 
 
 int main_orig( int argc, char *argv[] );
+int main_orig_ground( void );
 
 
 
@@ -1138,30 +1146,39 @@ extern FactList *gpredicates_and_types;
  *               predicate names,
  *               predicate aritys,
  *               defined types of predicate args
+ *
+ * (here and below, the tables without a fixed size grow as needed;
+ *  gmax_... is their allocated size, see grow_table in memory.c)
  */
-extern Token gconstants[MAX_CONSTANTS];
+extern Token *gconstants;
 extern int gnum_constants;
+extern int gmax_constants;
 extern Token gtype_names[MAX_TYPES];
-extern int gtype_consts[MAX_TYPES][MAX_TYPE];
-extern Bool gis_member[MAX_CONSTANTS][MAX_TYPES];
+extern int *gtype_consts[MAX_TYPES];
+extern int gmax_type_size[MAX_TYPES];
+extern Bool (*gis_member)[MAX_TYPES];
 extern int gtype_size[MAX_TYPES];
 extern int gnum_types;
-extern Token gpredicates[MAX_PREDICATES];
-extern int garity[MAX_PREDICATES];
-extern int gpredicates_args_type[MAX_PREDICATES][MAX_ARITY];
+extern Token *gpredicates;
+extern int *garity;
+extern int (*gpredicates_args_type)[MAX_ARITY];
 extern int gnum_predicates;
+extern int gmax_predicates;
 
 
 
 
 /* the domain in integer (Fact) representation
  */
-extern Operator_pointer goperators[MAX_OPERATORS];
+extern Operator_pointer *goperators;
 extern int gnum_operators;
-extern Fact gfull_initial[MAX_INITIAL];
+extern int gmax_operators;
+extern Fact *gfull_initial;
 extern int gnum_full_initial;
-extern Fact ggoal[MAX_STATE];
+extern int gmax_full_initial;
+extern Fact *ggoal;
 extern int gnum_goal;
+extern int gmax_goal;
 
 
 
@@ -1170,21 +1187,23 @@ extern int gnum_goal;
 /* stores inertia - information: is any occurence of the predicate
  * added / deleted in the uninstantiated ops ?
  */
-extern Bool gis_added[MAX_PREDICATES];
-extern Bool gis_deleted[MAX_PREDICATES];
+extern Bool *gis_added;
+extern Bool *gis_deleted;
 
 /* splitted initial state:
  * initial non static facts,
  * initial inertia facts of arity > 1
  */
-extern Fact ginitial[MAX_STATE];
+extern Fact *ginitial;
 extern int gnum_initial;
-extern Fact ginertia[MAX_INITIAL];
+extern int gmax_initial;
+extern Fact *ginertia;
 extern int gnum_inertia;
+extern int gmax_inertia;
 
 /* the type numbers corresponding to any unary inertia
  */
-extern int gtype_to_predicate[MAX_PREDICATES];
+extern int *gtype_to_predicate;
 extern int gpredicate_to_type[MAX_TYPES];
 
 /* (ordered) numbers of types that new type is intersection of
@@ -1210,8 +1229,9 @@ extern int gnum_templates;
 
 /* store the final "relevant facts"
  */
-extern Fact grelevant_facts[MAX_RELEVANT_FACTS];
+extern Fact *grelevant_facts;
 extern int gnum_relevant_facts;
+extern int gmax_relevant_facts;
 extern int gnum_pp_facts;
 
 /* the (fully instantiated) domain in integer 
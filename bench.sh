@@ -0,0 +1,267 @@
+#!/bin/sh
+#
+# Benchmark runner for pdr
+#
+#   bench.sh run [-t <sec>] [-b <binary>] [-o <csv>] [-J <json>] <corpus dir> [-- <pdr options>]
+#       runs pdr on every problem of the corpus (recursively) with the given time limit (default 300s)
+#       and writes one CSV row per instance (default bench.csv), optionally also as JSON
+#
+#   bench.sh compare [-r <percent>] <old csv> <new csv>
+#       compares two result files instance by instance; an instance solved before but not now,
+#       or slower by more than the given percentage (default 10) is flagged as a regression
+#       (exit status 1 if there is any)
+#
+# A problem file is any *.pddl whose name doesn't contain "domain"; its domain is the first of
+# <name>-domain.pddl, domain-<name>.pddl, domain_<name>.pddl and domain.pddl found next to it.
+#
+# The verdict and the plan length are taken from the output of pdr, the counters and timings
+# from its statistics stream (-J, so don't pass that one), summed over the phases; with -P those
+# of the member which answered (the first one if none did). On a timeout pdr is sent SIGINT,
+# so that it still writes the final record. time_total is measured here, as the wall-clock
+# time of the whole run (the others are measured by pdr itself).
+#
+# The instance is quoted (with any " doubled) as the only field that can contain commas.
+#
+
+COLUMNS="instance,verdict,plan_length,phases,oblig_processed,oblig_extended,oblig_sidestepped,oblig_blocked,oblig_subsumed,cla_derived,cla_subsumed,cla_pushed,cla_kept,time_extend,time_sat,time_side,time_uns,time_minimizing,time_subsumption,time_pushing,time_postprocessing,time_total,peak_kb"
+
+usage() {
+  sed -n '3,23p' "$0" | sed 's/^# \{0,1\}//'
+  exit 2
+}
+
+# the domain file for problem $1, or nothing
+find_domain() {
+  dir=`dirname "$1"`
+  name=`basename "$1" .pddl`
+  for d in "$dir/$name-domain.pddl" "$dir/domain-$name.pddl" "$dir/domain_$name.pddl" "$dir/domain.pddl"; do
+    if [ -f "$d" ]; then
+      echo "$d"
+      return
+    fi
+  done
+}
+
+# for awk: splits the CSV row in $0 into the instance (unquoted) and the other columns f[1], f[2], ...
+# (so column k of the file is f[k-1]); the instance is unquoted in files written before it was quoted
+SPLIT_ROW='
+  function split_row() {
+    if (substr($0,1,1) == "\"") {
+      match($0,/^"([^"]|"")*",/)
+      instance = substr($0,2,RLENGTH-3)
+      gsub(/""/,"\"",instance)
+      rest = substr($0,RLENGTH+1)
+    } else {
+      instance = substr($0,1,index($0,",")-1)
+      rest = substr($0,index($0,",")+1)
+    }
+    return split(rest,f,",")
+  }'
+
+# the current time in seconds (with the fraction where date supports %N)
+now() {
+  date +%s.%N | sed 's/\.N$//'
+}
+
+# one CSV row (without the instance name) from the output of pdr in $1 and its statistics stream in $2;
+# $3 is the exit status of timeout, $4 the wall-clock time of the run
+parse_log() {
+  awk -v status="$3" -v t_total="$4" '
+    # the number under key in the object obj of the JSON record rec (at the top level for obj "")
+    function num(rec, obj, key,   v) {
+      if (obj != "") {
+        if (!match(rec,"\"" obj "\":[{][^}]*[}]"))
+          return 0
+        rec = substr(rec,RSTART,RLENGTH)
+      }
+      if (!match(rec,"\"" key "\":-?[0-9.]+"))
+        return 0
+      v = substr(rec,RSTART,RLENGTH)
+      sub(/^[^:]*:/,"",v)
+      return v + 0
+    }
+    BEGIN { verdict = ""; len = ""; member = 0 }
+    FILENAME == ARGV[1] && /^(SAT|UNSAT|UNRESOLVED):/ && verdict == "" { verdict = substr($1,1,length($1)-1) }
+    FILENAME == ARGV[1] && /^SAT: plan of length/ { len = $5 }
+    FILENAME == ARGV[1] && /^Reduced to [0-9]+ actions/ { len = $3 }
+    FILENAME == ARGV[1] && /^Initial state satisfies the goal/ { verdict = "SAT"; len = 0 }
+    FILENAME == ARGV[1] && /^Portfolio member [0-9]+ answered first/ && $3 >= 0 { member = $3 }
+    FILENAME == ARGV[2] && /^[{]/ {
+      if (/^[{]"member":/ && num($0,"","member") != member)
+        next
+      records++
+      phases = num($0,"","phase")
+      o_proc += num($0,"obligations","processed")
+      o_ext += num($0,"obligations","extended")
+      o_side += num($0,"obligations","sidestepped")
+      o_blk += num($0,"obligations","blocked")
+      o_sub += num($0,"obligations","subsumed")
+      c_der += num($0,"clauses","derived")
+      c_sub += num($0,"clauses","subsumed")
+      c_push += num($0,"clauses","pushed")
+      t_sat += num($0,"time","extend_sat")
+      t_side += num($0,"time","extend_side")
+      t_uns += num($0,"time","extend_uns")
+      t_min += num($0,"time","minimizing")
+      t_subs += num($0,"time","subsumption")
+      t_push += num($0,"time","pushing")
+      t_post += num($0,"time","postprocessing")
+      if (num($0,"memory","peak_rss_kb") > peak)
+        peak = num($0,"memory","peak_rss_kb")
+      # the clauses kept are those of the layers (but the goal one) in the last record
+      c_kept = 0
+      if (match($0,/"layers":\[[^]]*\]/)) {
+        layers = substr($0,RSTART,RLENGTH)
+        for (i = 0; match(layers,/"delta":[0-9]+/); i++) {
+          if (i)
+            c_kept += substr(layers,RSTART+8,RLENGTH-8)
+          layers = substr(layers,RSTART+RLENGTH)
+        }
+      }
+    }
+    END {
+      if (status == 124 || status == 137)
+        verdict = "TIMEOUT"
+      else if (verdict == "")
+        verdict = "ERROR"
+      if (!records)
+        printf "%s,%s,,,,,,,,,,,,,,,,,,,%s,\n", verdict, len, t_total
+      else
+        printf "%s,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%s,%d\n", verdict, len, phases,
+          o_proc, o_ext, o_side, o_blk, o_sub, c_der, c_sub, c_push, c_kept,
+          t_sat + t_side + t_uns, t_sat, t_side, t_uns, t_min, t_subs, t_push, t_post, t_total, peak
+    }' "$1" "$2"
+}
+
+# the rows of CSV $1 as a JSON array into $2 (the numbers stay numbers, the rest become strings)
+csv_to_json() {
+  awk "$SPLIT_ROW"'
+    NR == 1 { n = split($0,cols,","); print "["; next }
+    {
+      if (NR > 2) print ","
+      printf "  {"
+      split_row()
+      for (i = 1; i <= n; i++) {
+        v = (i == 1 ? instance : f[i-1])
+        if (i == 1 || (v != "" && v !~ /^-?[0-9]+(\.[0-9]+)?$/)) {
+          gsub(/\\/,"\\\\",v)
+          gsub(/"/,"\\\"",v)
+          v = "\"" v "\""
+        } else if (v == "")
+          v = "null"
+        printf "%s\"%s\": %s", (i > 1 ? ", " : ""), cols[i], v
+      }
+      printf "}"
+    }
+    END { print ""; print "]" }' "$1" > "$2"
+}
+
+run() {
+  limit=300
+  binary=./pdr
+  csv=bench.csv
+  json=
+  while getopts "t:b:o:J:" opt; do
+    case $opt in
+      t) limit=$OPTARG ;;
+      b) binary=$OPTARG ;;
+      o) csv=$OPTARG ;;
+      J) json=$OPTARG ;;
+      *) usage ;;
+    esac
+  done
+  shift `expr $OPTIND - 1`
+  [ $# -ge 1 ] || usage
+  corpus=$1
+  shift
+  [ "$1" = "--" ] && shift
+
+  [ -x "$binary" ] || { echo "bench: $binary is not executable" >&2; exit 2; }
+  [ -d "$corpus" ] || { echo "bench: $corpus is not a directory" >&2; exit 2; }
+
+  log=`mktemp`
+  stream=`mktemp`
+  echo "$COLUMNS" > "$csv"
+
+  find "$corpus" -name '*.pddl' ! -name '*domain*' | sort | while read -r problem; do
+    domain=`find_domain "$problem"`
+    if [ -z "$domain" ]; then
+      echo "bench: no domain for $problem, skipped" >&2
+      continue
+    fi
+
+    start=`now`
+    timeout -s INT -k 10 "$limit" "$binary" -o "$domain" -f "$problem" -J "$stream" "$@" > "$log" 2>&1
+    status=$?
+    end=`now`
+    wall=`awk -v s="$start" -v e="$end" 'BEGIN { printf "%.3f", e - s }'`
+
+    row=`parse_log "$log" "$stream" $status $wall`
+    quoted=`echo "$problem" | sed 's/"/""/g'`
+    echo "\"$quoted\",$row" >> "$csv"
+    echo "$problem: `echo "$row" | cut -d, -f1`" >&2
+  done
+
+  rm -f "$log" "$stream"
+  [ -n "$json" ] && csv_to_json "$csv" "$json"
+  exit 0
+}
+
+compare() {
+  ratio=10
+  while getopts "r:" opt; do
+    case $opt in
+      r) ratio=$OPTARG ;;
+      *) usage ;;
+    esac
+  done
+  shift `expr $OPTIND - 1`
+  [ $# -eq 2 ] || usage
+
+  # the columns are looked up by their names in the header of each file (f[k-1] is column k, see split_row)
+  awk -v ratio="$ratio" "$SPLIT_ROW"'
+    FNR == 1 {
+      split("",col)
+      n = split($0,names,",")
+      for (k = 1; k <= n; k++)
+        col[names[k]] = k - 1
+      next
+    }
+    { split_row(); i = instance; v = f[col["verdict"]]; l = f[col["plan_length"]]; t = f[col["time_total"]] }
+    NR == FNR { verdict[i] = v; len[i] = l; total[i] = t; next }
+    {
+      if (!(i in verdict)) { printf "%-50s new instance\n", i; next }
+      old_solved = (verdict[i] == "SAT" || verdict[i] == "UNSAT")
+      new_solved = (v == "SAT" || v == "UNSAT")
+      compared++
+      if (old_solved && !new_solved) {
+        printf "%-50s REGRESSION: %s before, %s now\n", i, verdict[i], v; bad++
+      } else if (!old_solved && new_solved) {
+        printf "%-50s improved: %s before, %s now\n", i, verdict[i], v
+      } else if (old_solved && new_solved) {
+        if (verdict[i] != v) {
+          printf "%-50s MISMATCH: %s before, %s now\n", i, verdict[i], v; bad++
+        }
+        old_sum += total[i]; new_sum += t
+        if (t > total[i] * (1 + ratio/100.0) && t - total[i] > 0.1) {
+          printf "%-50s REGRESSION: %.2fs before, %.2fs now\n", i, total[i], t; bad++
+        } else if (t < total[i] * (1 - ratio/100.0) && total[i] - t > 0.1)
+          printf "%-50s faster: %.2fs before, %.2fs now\n", i, total[i], t
+        if (v == "SAT" && l > len[i])
+          printf "%-50s longer plan: %d before, %d now\n", i, len[i], l
+      }
+    }
+    END {
+      printf "\n%d instances compared, %d regressions; %.2fs before and %.2fs now on those solved by both.\n", compared, bad, old_sum, new_sum
+      exit (bad > 0)
+    }' "$1" "$2"
+}
+
+[ $# -ge 1 ] || usage
+cmd=$1
+shift
+case $cmd in
+  run) run "$@" ;;
+  compare) compare "$@" ;;
+  *) usage ;;
+esac
@@ -150,17 +150,15 @@ void collect_all_strings( void )
       gtype_names[gnum_types] = new_Token( strlen( f->item->next->item ) + 1 );
       strcpy( gtype_names[gnum_types], f->item->next->item );
       gtype_size[gnum_types] = 0;
-      for ( i = 0; i < MAX_CONSTANTS; i++ ) {
+      for ( i = 0; i < gmax_constants; i++ ) {
 	gis_member[i][gnum_types] = FALSE;
       }
       type_num = gnum_types++;
     }
 
     if ( (c_num = position_in_constants_table( f->item->item )) == -1 ) {
-      if ( gnum_constants == MAX_CONSTANTS ) {
-	printf("\ntoo many constants! increase MAX_CONSTANTS (currently %d)\n\n",
-	       MAX_CONSTANTS);
-	exit( 1 );
+      if ( gnum_constants == gmax_constants ) {
+	grow_constants_tables();
       }
       gconstants[gnum_constants] = new_Token( strlen( f->item->item ) + 1 );
       strcpy( gconstants[gnum_constants], f->item->item );
@@ -168,10 +166,8 @@ void collect_all_strings( void )
     }
     
     if ( !gis_member[c_num][type_num] ) {
-      if ( gtype_size[type_num] == MAX_TYPE ) {
-	printf("\ntoo many consts in type %s! increase MAX_TYPE (currently %d)\n\n",
-	       gtype_names[type_num], MAX_TYPE);
-	exit( 1 );
+      if ( gtype_size[type_num] == gmax_type_size[type_num] ) {
+	grow_type_table( type_num );
       }     
       gtype_consts[type_num][gtype_size[type_num]++] = c_num;
       gis_member[c_num][type_num] = TRUE;
@@ -183,10 +179,8 @@ void collect_all_strings( void )
       printf("\npredicate %s declared twice!\n\n", f->item->item);
       exit( 1 );
     }
-    if ( gnum_predicates == MAX_PREDICATES ) {
-      printf("\ntoo many predicates! increase MAX_PREDICATES (currently %d)\n\n",
-	     MAX_PREDICATES);
-      exit( 1 );
+    if ( gnum_predicates == gmax_predicates ) {
+      grow_predicates_tables();
     }
     gpredicates[gnum_predicates] = new_Token( strlen( f->item->item ) + 1 );
     strcpy( gpredicates[gnum_predicates], f->item->item );
@@ -271,6 +265,53 @@ int position_in_predicates_table( char *str )
 
 
 
+/* the tables indexed by constants and by predicates grow together
+ */
+void grow_constants_tables( void )
+
+{
+
+  int new_max = gmax_constants ? 2 * gmax_constants : INITIAL_TABLE_SIZE;
+
+  gconstants = grow_table( gconstants, gmax_constants, new_max, sizeof( Token ) );
+  gis_member = grow_table( gis_member, gmax_constants, new_max, sizeof( *gis_member ) );
+  gmax_constants = new_max;
+
+}
+
+
+
+void grow_type_table( int t )
+
+{
+
+  int new_max = gmax_type_size[t] ? 2 * gmax_type_size[t] : INITIAL_TABLE_SIZE;
+
+  gtype_consts[t] = grow_table( gtype_consts[t], gmax_type_size[t], new_max, sizeof( int ) );
+  gmax_type_size[t] = new_max;
+
+}
+
+
+
+void grow_predicates_tables( void )
+
+{
+
+  int new_max = gmax_predicates ? 2 * gmax_predicates : INITIAL_TABLE_SIZE;
+
+  gpredicates = grow_table( gpredicates, gmax_predicates, new_max, sizeof( Token ) );
+  garity = grow_table( garity, gmax_predicates, new_max, sizeof( int ) );
+  gpredicates_args_type = grow_table( gpredicates_args_type, gmax_predicates, new_max, sizeof( *gpredicates_args_type ) );
+  gis_added = grow_table( gis_added, gmax_predicates, new_max, sizeof( Bool ) );
+  gis_deleted = grow_table( gis_deleted, gmax_predicates, new_max, sizeof( Bool ) );
+  gtype_to_predicate = grow_table( gtype_to_predicate, gmax_predicates, new_max, sizeof( int ) );
+  gmax_predicates = new_max;
+
+}
+
+
+
 void create_integer_representation( void )
 
 {
@@ -279,14 +320,12 @@ void create_integer_representation( void )
   PlOperator *o;
   Operator *tmp;
   FactList *ff;
-  int type_num, i;
+  int type_num, i, new_max;
 
   if ( gorig_initial_facts ) {
     for ( n = gorig_initial_facts->sons; n; n = n->next ) {
-      if ( gnum_full_initial == MAX_INITIAL ) {
-	printf("\ntoo many initial facts! increase MAX_INITIAL (currently %d)\n\n",
-	       MAX_INITIAL);
-	exit( 1 );
+      if ( gnum_full_initial == gmax_full_initial ) {
+	gfull_initial = grow_fact_table( gfull_initial, &gmax_full_initial );
       }
       make_Fact( &(gfull_initial[gnum_full_initial]), n, NULL );
       if ( gfull_initial[gnum_full_initial].predicate == -1 ) {
@@ -300,10 +339,8 @@ void create_integer_representation( void )
 
   if ( gorig_goal_facts ) {
     for ( n = gorig_goal_facts->sons; n; n = n->next ) {
-      if ( gnum_goal == MAX_STATE ) {
-	printf("\ntoo many goal facts! increase MAX_STATE (currently %d)\n\n",
-	       MAX_STATE);
-	exit( 1 );
+      if ( gnum_goal == gmax_goal ) {
+	ggoal = grow_fact_table( ggoal, &gmax_goal );
       }
       make_Fact( &(ggoal[gnum_goal]), n, NULL );
       if ( ggoal[gnum_goal].predicate == -1 ) {
@@ -386,10 +423,10 @@ void create_integer_representation( void )
       }
     }
 
-    if ( gnum_operators == MAX_OPERATORS ) {
-      printf("\ntoo many operators! increase MAX_OPERATORS (currently %d)\n\n",
-	     MAX_OPERATORS);
-      exit( 1 );
+    if ( gnum_operators == gmax_operators ) {
+      new_max = gmax_operators ? 2 * gmax_operators : INITIAL_TABLE_SIZE;
+      goperators = grow_table( goperators, gmax_operators, new_max, sizeof( Operator_pointer ) );
+      gmax_operators = new_max;
     }
     goperators[gnum_operators++] = tmp;
   }
@@ -1020,7 +1057,7 @@ void split_initial_state( void )
 
   int i, j, p, t;
 
-  for ( i = 0; i < MAX_PREDICATES; i++ ) {
+  for ( i = 0; i < gnum_predicates; i++ ) {
     gtype_to_predicate[i] = -1;
   }
   for ( i = 0; i < MAX_TYPES; i++ ) {
@@ -1042,16 +1079,14 @@ void split_initial_state( void )
 	  gpredicate_to_type[gnum_types] = p;
 	  gtype_names[gnum_types] = NULL;
 	  gtype_size[gnum_types] = 0;
-	  for ( j = 0; j < MAX_CONSTANTS; j++ ) {
+	  for ( j = 0; j < gmax_constants; j++ ) {
 	    gis_member[j][gnum_types] = FALSE;
 	  }
 	  t = gnum_types;
 	  gnum_types++;
 	}
-	if ( gtype_size[t] == MAX_TYPE ) {
-	  printf("\ntoo many consts in type %s! increase MAX_TYPE (currently %d)\n\n",
-		 gtype_names[t], MAX_TYPE);
-	  exit( 1 );
+	if ( gtype_size[t] == gmax_type_size[t] ) {
+	  grow_type_table( t );
 	}
 	if ( !gis_member[gfull_initial[i].args[0]][gpredicates_args_type[p][0]] ) {
 	  printf("\ntype mismatch in initial state! %s as arg 0 of %s\n\n",
@@ -1061,10 +1096,8 @@ void split_initial_state( void )
 	gtype_consts[t][gtype_size[t]++] = gfull_initial[i].args[0];
 	gis_member[gfull_initial[i].args[0]][t] = TRUE;
       } else {
-	if ( gnum_inertia == MAX_INITIAL ) {
-	  printf("\ntoo many inertia! increase MAX_INITIAL (currently %d)\n\n",
-		 MAX_INITIAL);
-	  exit( 1 );
+	if ( gnum_inertia == gmax_inertia ) {
+	  ginertia = grow_fact_table( ginertia, &gmax_inertia );
 	}
 	ginertia[gnum_inertia].predicate = p;
 	for ( j = 0; j < garity[p]; j++ ) {
@@ -1079,10 +1112,8 @@ void split_initial_state( void )
       }
       continue;
     }
-    if ( gnum_initial == MAX_STATE ) {
-      printf("\ntoo many non static initials! increase MAX_STATE (currently %d)\n\n",
-	     MAX_STATE);
-      exit( 1 );
+    if ( gnum_initial == gmax_initial ) {
+      ginitial = grow_fact_table( ginitial, &gmax_initial );
     }
     ginitial[gnum_initial].predicate = p;
     for ( j = 0; j < garity[p]; j++ ) {
@@ -1190,7 +1221,7 @@ void encode_unary_inertia_as_types( void )
       } 
       gtype_names[gnum_types] = NULL;
       gtype_size[gnum_types] = 0;
-      for ( j = 0; j < MAX_CONSTANTS; j++ ) {
+      for ( j = 0; j < gmax_constants; j++ ) {
 	gis_member[j][gnum_types] = FALSE;
       }
       for ( j = 0; j < num_T; j++ ) {
@@ -1212,10 +1243,8 @@ void encode_unary_inertia_as_types( void )
 	}
 	/* add constant to new type
 	 */
-	if ( gtype_size[intersected_type] == MAX_TYPE ) {
-	  printf("\ntoo many consts in type %s! increase MAX_TYPE (currently %d)\n\n",
-		 gtype_names[intersected_type], MAX_TYPE);
-	  exit( 1 );
+	if ( gtype_size[intersected_type] == gmax_type_size[intersected_type] ) {
+	  grow_type_table( intersected_type );
 	}
 	gtype_consts[intersected_type][gtype_size[intersected_type]++] = gtype_consts[T[0]][j];
 	gis_member[gtype_consts[T[0]][j]][intersected_type] = TRUE;
@@ -1233,7 +1262,7 @@ void encode_unary_inertia_as_types( void )
 	 * remove intersected type from table!
 	 */
 	gtype_size[intersected_type] = 0;
-	for ( k = 0; k < MAX_CONSTANTS; k++ ) {
+	for ( k = 0; k < gmax_constants; k++ ) {
 	  gis_member[k][intersected_type] = FALSE;
 	}
 	gnum_intersected_types[intersected_type] = -1;
@@ -46,6 +46,9 @@ void collect_all_strings( void );
 int position_in_types_table( char *str );
 int position_in_constants_table( char *str );
 int position_in_predicates_table( char *str );
+void grow_constants_tables( void );
+void grow_type_table( int t );
+void grow_predicates_tables( void );
 void create_integer_representation( void );
 void make_Fact( Fact *f, PlNode *n, Operator *o );
 Bool is_subtype( int t1, int t2 );
@@ -76,7 +76,7 @@ int lnum_multiply_parameters;
 Operator *lo;
 int lo_num;
 
-Bool lused_constant[MAX_CONSTANTS];
+Bool *lused_constant;
 
 
 
@@ -91,6 +91,9 @@ void build_action_templates( void )
   ActionTemplate *t;
   Operator *o;
 
+  lused_constant = ( Bool * ) calloc( gnum_constants, sizeof( Bool ) );
+  CHECK_PTR( lused_constant );
+
   for ( i = 0; i < gnum_operators; i++ ) {
     lo = goperators[i];
     lo_num = i;
@@ -194,7 +197,7 @@ void unify_inertia_preconds( int curr_inertia )
 
   int p, i, j, k, af;
   int args[MAX_VARS];
-  int affected_params[MAX_VARS];
+  int affected_params[MAX_VARS] = { 0 };
   int num_affected_params = 0;
 
   if ( curr_inertia == lnum_inertia_preconds ) {
@@ -358,10 +361,32 @@ void multiply_parameters( int curr_parameter )
 /* local globals for this part
  */
 
-int_pointer lpos[MAX_PREDICATES];
-int_pointer lneg[MAX_PREDICATES];
-int_pointer luse[MAX_PREDICATES];
-int_pointer lindex[MAX_PREDICATES];
+/* the facts met so far (the initial ones, the preconditions of the
+ * templates still waiting for them, the adds and the deletes; so linear
+ * in the size of the template list): slot s > 0 holds the fact lfacts[s],
+ * with the flags lpos[s], lneg[s], luse[s] and the relevant fact number
+ * lindex[s]; slot 0 stands for all the others (flags 0, index -1).
+ * the slots are found via lhash, open addressing with linear probing.
+ */
+Fact *lfacts;
+int *lpos;
+int *lneg;
+int *luse;
+int *lindex;
+int lnum_facts;
+int lmax_facts;
+
+/* the templates waiting on slot s (for its fact to get possibly positive)
+ * are lwaiting_template[w] for w = lwaiting[s], lwaiting_next[w], ... up to 0
+ */
+int *lwaiting;
+int *lwaiting_template;
+int *lwaiting_next;
+int lnum_waiting;
+int lmax_waiting;
+
+int *lhash;
+int lhash_size;
 
 int lp;
 int largs[MAX_VARS];
@@ -377,34 +402,27 @@ void perform_reachability_analysis( void )
 
 {
 
-  int size, i, j, adr;
-  Bool fixpoint;
-  ActionTemplate *t1, *t2, *t3;
+  int i, j, k, r, w, adr;
+  int num_templates, num_ready;
+  ActionTemplate *t1, **templates;
+  int *unsatisfied, *ready;
   Operator *o;
   Action *tmp, *a;
 
-  for ( i = 0; i < gnum_predicates; i++ ) {
-    size =  1;
-    for ( j = 0; j < garity[i]; j++ ) {
-      size *= gnum_constants;
-    }
-
-    lpos[i] = ( int_pointer ) calloc( size, sizeof( int ) );
-    CHECK_PTR( lpos[i] );
-    lneg[i] = ( int_pointer ) calloc( size, sizeof( int ) );
-    CHECK_PTR( lneg[i] );
-    luse[i] = ( int_pointer ) calloc( size, sizeof( int ) );
-    CHECK_PTR( luse[i] );
-    lindex[i] = ( int_pointer ) calloc( size, sizeof( int ) );
-    CHECK_PTR( lindex[i] );
-
-    for ( j = 0; j < size; j++ ) {
-      lpos[i][j] = 0;
-      lneg[i][j] = 0;
-      luse[i][j] = 0;
-      lindex[i][j] = -1;
-    }
-  }
+  lfacts = NULL;
+  lpos = NULL;
+  lneg = NULL;
+  luse = NULL;
+  lindex = NULL;
+  lwaiting = NULL;
+  lmax_facts = 0;
+  grow_fact_slots();
+  lindex[0] = -1;
+  lnum_facts = 1;
+
+  lhash_size = 2 * INITIAL_TABLE_SIZE;
+  lhash = ( int * ) calloc( lhash_size, sizeof( int ) );
+  CHECK_PTR( lhash );
 
   /* mark initial facts as possibly positive
    */
@@ -413,132 +431,108 @@ void perform_reachability_analysis( void )
     for ( j = 0; j < garity[lp]; j++ ) {
       largs[j] = ginitial[i].args[j];
     }
-    lpos[lp][fact_adress()] = 1;
+    lpos[new_fact_adress()] = 1;
   }
 
-  /* compute fixpoint
+  /* compute fixpoint: a template fires once all its preconds are
+   * possibly positive; it waits on the slots of the ones that aren't yet
+   * and the last of them to get reached puts it into the ready queue
    */
-  fixpoint = FALSE;
-  while ( !fixpoint ) {
-    fixpoint = TRUE;
-
-    t1 = gtemplates;
-    while ( t1 ) {
-      o = goperators[t1->op];
-      for ( i = 0; i < o->num_preconds; i++ ) {
-	lp = o->preconds[i].predicate;
-	for ( j = 0; j < garity[lp]; j++ ) {
-	  largs[j] = GET_CONSTANT( o->preconds[i].args[j], t1 );
-	}
-	if ( !lpos[lp][fact_adress()] ) {
-	  break;
-	}
+  num_templates = 0;
+  for ( t1 = gtemplates; t1; t1 = t1->next ) {
+    num_templates++;
+  }
+  templates = ( ActionTemplate ** ) calloc( num_templates + 1, sizeof( ActionTemplate * ) );
+  CHECK_PTR( templates );
+  unsatisfied = ( int * ) calloc( num_templates + 1, sizeof( int ) );
+  CHECK_PTR( unsatisfied );
+  ready = ( int * ) calloc( num_templates + 1, sizeof( int ) );
+  CHECK_PTR( ready );
+  num_ready = 0;
+
+  lwaiting_template = NULL;
+  lwaiting_next = NULL;
+  lmax_waiting = 0;
+  lnum_waiting = 1;
+  for ( k = 0, t1 = gtemplates; t1; k++, t1 = t1->next ) {
+    templates[k] = t1;
+    o = goperators[t1->op];
+    for ( i = 0; i < o->num_preconds; i++ ) {
+      lp = o->preconds[i].predicate;
+      for ( j = 0; j < garity[lp]; j++ ) {
+	largs[j] = GET_CONSTANT( o->preconds[i].args[j], t1 );
       }
-
-      if ( i < o->num_preconds ) {
-	break;
+      /* a slot is only needed to wait on
+       */
+      if ( !lpos[fact_adress()] ) {
+	unsatisfied[k]++;
+	add_waiting( new_fact_adress(), k );
       }
+    }
+    if ( unsatisfied[k] == 0 ) {
+      ready[num_ready++] = k;
+    }
+  }
 
-      for ( i = 0; i < o->num_adds; i++ ) {
-	lp = o->adds[i].predicate;
-	for ( j = 0; j < garity[lp]; j++ ) {
-	  largs[j] = GET_CONSTANT( o->adds[i].args[j], t1 );
-	}
-	adr = fact_adress();
-	if ( !lpos[lp][adr] ) {
-	  /* new relevant fact! (added non initial)
-	   */
-	  lpos[lp][adr] = 1;
-	  lneg[lp][adr] = 1;
-	  luse[lp][adr] = 1;
-	  if ( gnum_relevant_facts == MAX_RELEVANT_FACTS ) {
-	    printf("\ntoo many relevant facts! increase MAX_RELEVANT_FACTS (currently %d)\n\n",
-		   MAX_RELEVANT_FACTS);
-	    exit( 1 );
-	  }
-	  grelevant_facts[gnum_relevant_facts].predicate = lp;
-	  for ( j = 0; j < garity[lp]; j++ ) {
-	    grelevant_facts[gnum_relevant_facts].args[j] = largs[j];
-	  }
-	  lindex[lp][adr] = gnum_relevant_facts;
-	  gnum_relevant_facts++;
-	  fixpoint = FALSE;
-	}
-      }
+  for ( r = 0; r < num_ready; r++ ) {
+    t1 = templates[ready[r]];
+    o = goperators[t1->op];
 
-      tmp = new_Action( t1->op );
-      for ( i = 0; i < o->num_vars; i++ ) {
-	tmp->inst_table[i] = t1->inst_table[i];
+    for ( i = 0; i < o->num_adds; i++ ) {
+      lp = o->adds[i].predicate;
+      for ( j = 0; j < garity[lp]; j++ ) {
+	largs[j] = GET_CONSTANT( o->adds[i].args[j], t1 );
       }
-      tmp->next = gactions;
-      gactions = tmp;
-      gnum_actions++;
-
-      t2 = t1;
-      t1 = t1->next;
-      free_single_ActionTemplate( t2 );
-    }
-    gtemplates = t1;
-    t3 = t1;
-    if ( t1 ) t1 = t1->next;
-    while ( t1 ) {
-      o = goperators[t1->op];
-      for ( i = 0; i < o->num_preconds; i++ ) {
-	lp = o->preconds[i].predicate;
-	for ( j = 0; j < garity[lp]; j++ ) {
-	  largs[j] = GET_CONSTANT( o->preconds[i].args[j], t1 );
+      adr = new_fact_adress();
+      if ( !lpos[adr] ) {
+	/* new relevant fact! (added non initial)
+	 */
+	lpos[adr] = 1;
+	lneg[adr] = 1;
+	luse[adr] = 1;
+	if ( gnum_relevant_facts == gmax_relevant_facts ) {
+	  grelevant_facts = grow_fact_table( grelevant_facts, &gmax_relevant_facts );
 	}
-	if ( !lpos[lp][fact_adress()] ) {
-	  break;
+	grelevant_facts[gnum_relevant_facts].predicate = lp;
+	for ( j = 0; j < garity[lp]; j++ ) {
+	  grelevant_facts[gnum_relevant_facts].args[j] = largs[j];
 	}
-      }
+	lindex[adr] = gnum_relevant_facts;
+	gnum_relevant_facts++;
 
-      if ( i == o->num_preconds ) {
-	for ( i = 0; i < o->num_adds; i++ ) {
-	  lp = o->adds[i].predicate;
-	  for ( j = 0; j < garity[lp]; j++ ) {
-	    largs[j] = GET_CONSTANT( o->adds[i].args[j], t1 );
-	  }
-	  adr = fact_adress();
-	  if ( !lpos[lp][adr] ) {
-	    /* new relevant fact! (added non initial)
-	     */
-	    lpos[lp][adr] = 1;
-	    lneg[lp][adr] = 1;
-	    luse[lp][adr] = 1;
-	    if ( gnum_relevant_facts == MAX_RELEVANT_FACTS ) {
-	      printf("\ntoo many relevant facts! increase MAX_RELEVANT_FACTS (currently %d)\n\n",
-		     MAX_RELEVANT_FACTS);
-	      exit( 1 );
-	    }
-	    grelevant_facts[gnum_relevant_facts].predicate = lp;
-	    for ( j = 0; j < garity[lp]; j++ ) {
-	      grelevant_facts[gnum_relevant_facts].args[j] = largs[j];
-	    }
-	    lindex[lp][adr] = gnum_relevant_facts;
-	    gnum_relevant_facts++;
-	    fixpoint = FALSE;
+	for ( w = lwaiting[adr]; w; w = lwaiting_next[w] ) {
+	  if ( --unsatisfied[lwaiting_template[w]] == 0 ) {
+	    ready[num_ready++] = lwaiting_template[w];
 	  }
 	}
-
-	tmp = new_Action( t1->op );
-	for ( i = 0; i < o->num_vars; i++ ) {
-	  tmp->inst_table[i] = t1->inst_table[i];
-	}
-	tmp->next = gactions;
-	gactions = tmp;
-	gnum_actions++;
-	
-	t3->next = t1->next;
-	t2 = t1;
-	t1 = t1->next;
-	free_single_ActionTemplate( t2 );
-      } else {
-	t3 = t3->next;
-	t1 = t1->next;
       }
     }
+
+    tmp = new_Action( t1->op );
+    for ( i = 0; i < o->num_vars; i++ ) {
+      tmp->inst_table[i] = t1->inst_table[i];
+    }
+    tmp->next = gactions;
+    gactions = tmp;
+    gnum_actions++;
+  }
+
+  /* the templates that never fired stay in gtemplates
+   */
+  gtemplates = NULL;
+  for ( k = num_templates - 1; k >= 0; k-- ) {
+    if ( unsatisfied[k] ) {
+      templates[k]->next = gtemplates;
+      gtemplates = templates[k];
+    } else {
+      free_single_ActionTemplate( templates[k] );
+    }
   }
+  free( templates );
+  free( unsatisfied );
+  free( ready );
+  free( lwaiting_template );
+  free( lwaiting_next );
 
   gnum_pp_facts = gnum_initial + gnum_relevant_facts;
 
@@ -582,7 +576,7 @@ void perform_reachability_analysis( void )
     for ( j = 0; j < garity[lp]; j++ ) {
       largs[j] = ggoal[i].args[j];
     }
-    if ( !lpos[lp][fact_adress()] ) {
+    if ( !lpos[fact_adress()] ) {
       printf("\nproblem is unsolvable! goals can't be reached\n\n");
       output_planner_info();
       exit(UNSAT);
@@ -594,18 +588,139 @@ void perform_reachability_analysis( void )
 
 
 
+/* the slot of the fact lp( largs ), 0 if it has none
+ */
 int fact_adress( void )
 
 {
 
-  int r = 0, b = 1, i;
+  return lhash[fact_hash_position( lp, largs )];
+
+}
+
+
+
+/* the slot of the fact lp( largs ), a new one if it has none
+ */
+int new_fact_adress( void )
+
+{
 
-  for ( i = garity[lp] - 1; i > -1; i-- ) {
-    r += b * largs[i];
-    b *= gnum_constants;
+  int pos = fact_hash_position( lp, largs ), s, j;
+
+  if ( lhash[pos] ) {
+    return lhash[pos];
+  }
+
+  if ( lnum_facts == lmax_facts ) {
+    grow_fact_slots();
+  }
+  s = lnum_facts++;
+  lfacts[s].predicate = lp;
+  for ( j = 0; j < garity[lp]; j++ ) {
+    lfacts[s].args[j] = largs[j];
+  }
+  lindex[s] = -1;
+  lhash[pos] = s;
+
+  /* keep the table at most half full
+   */
+  if ( 2 * lnum_facts > lhash_size ) {
+    rehash_fact_slots();
+  }
+
+  return s;
+
+}
+
+
+
+/* where the fact p( args ) is in lhash, or the empty position it would go to
+ */
+int fact_hash_position( int p, int *args )
+
+{
+
+  unsigned int h = ( unsigned int ) p * 2654435761u;
+  int pos, s, j;
+
+  for ( j = 0; j < garity[p]; j++ ) {
+    h = ( h ^ ( unsigned int ) args[j] ) * 2654435761u;
+  }
+  h ^= h >> 16;
+
+  for ( pos = h & ( lhash_size - 1 ); ( s = lhash[pos] ) != 0; pos = ( pos + 1 ) & ( lhash_size - 1 ) ) {
+    if ( lfacts[s].predicate != p ) {
+      continue;
+    }
+    for ( j = 0; j < garity[p]; j++ ) {
+      if ( lfacts[s].args[j] != args[j] ) {
+	break;
+      }
+    }
+    if ( j == garity[p] ) {
+      break;
+    }
+  }
+
+  return pos;
+
+}
+
+
+
+void grow_fact_slots( void )
+
+{
+
+  int new_max = lmax_facts ? 2 * lmax_facts : INITIAL_TABLE_SIZE;
+
+  lfacts = grow_table( lfacts, lmax_facts, new_max, sizeof( Fact ) );
+  lpos = grow_table( lpos, lmax_facts, new_max, sizeof( int ) );
+  lneg = grow_table( lneg, lmax_facts, new_max, sizeof( int ) );
+  luse = grow_table( luse, lmax_facts, new_max, sizeof( int ) );
+  lindex = grow_table( lindex, lmax_facts, new_max, sizeof( int ) );
+  lwaiting = grow_table( lwaiting, lmax_facts, new_max, sizeof( int ) );
+  lmax_facts = new_max;
+
+}
+
+
+
+void add_waiting( int adr, int t )
+
+{
+
+  int new_max;
+
+  if ( lnum_waiting >= lmax_waiting ) {
+    new_max = lmax_waiting ? 2 * lmax_waiting : INITIAL_TABLE_SIZE;
+    lwaiting_template = grow_table( lwaiting_template, lmax_waiting, new_max, sizeof( int ) );
+    lwaiting_next = grow_table( lwaiting_next, lmax_waiting, new_max, sizeof( int ) );
+    lmax_waiting = new_max;
   }
+  lwaiting_template[lnum_waiting] = t;
+  lwaiting_next[lnum_waiting] = lwaiting[adr];
+  lwaiting[adr] = lnum_waiting++;
+
+}
+
 
-  return r;
+
+void rehash_fact_slots( void )
+
+{
+
+  int s;
+
+  free( lhash );
+  lhash_size *= 2;
+  lhash = ( int * ) calloc( lhash_size, sizeof( int ) );
+  CHECK_PTR( lhash );
+
+  for ( s = 1; s < lnum_facts; s++ ) {
+    lhash[fact_hash_position( lfacts[s].predicate, lfacts[s].args )] = s;
+  }
 
 }
 
@@ -651,23 +766,21 @@ void collect_relevant_facts( void )
       for ( j = 0; j < garity[lp]; j++ ) {
 	largs[j] = GET_CONSTANT( o->dels[i].args[j], a );
       }
-      adr = fact_adress();
-
-      lneg[lp][adr] = 1;
-      if ( lpos[lp][adr] &&
-	   !luse[lp][adr] ) {
-	luse[lp][adr] = 1;
-	lindex[lp][adr] = gnum_relevant_facts;
-	if ( gnum_relevant_facts == MAX_RELEVANT_FACTS ) {
-	  printf("\nincrease MAX_RELEVANT_FACTS! (current value: %d)\n\n",
-		 MAX_RELEVANT_FACTS);
-	  exit( 1 );
+      adr = new_fact_adress();
+
+      lneg[adr] = 1;
+      if ( lpos[adr] &&
+	   !luse[adr] ) {
+	luse[adr] = 1;
+	lindex[adr] = gnum_relevant_facts;
+	if ( gnum_relevant_facts == gmax_relevant_facts ) {
+	  grelevant_facts = grow_fact_table( grelevant_facts, &gmax_relevant_facts );
 	}
 	grelevant_facts[gnum_relevant_facts].predicate = lp;
 	for ( j = 0; j < garity[lp]; j++ ) {
 	  grelevant_facts[gnum_relevant_facts].args[j] = largs[j];
 	}
-	lindex[lp][adr] = gnum_relevant_facts;
+	lindex[adr] = gnum_relevant_facts;
 	gnum_relevant_facts++;
       }
     }
@@ -685,11 +798,11 @@ void collect_relevant_facts( void )
       }
       adr = fact_adress();
 
-      if ( !lneg[lp][adr] ) {
+      if ( !lneg[adr] ) {
 	continue;
       }
 
-      a->preconds[a->num_preconds++] = lindex[lp][adr];
+      a->preconds[a->num_preconds++] = lindex[adr];
     }
 
     for ( i = 0; i < o->num_adds; i++ ) {
@@ -699,11 +812,11 @@ void collect_relevant_facts( void )
       }
       adr = fact_adress();
 
-      if ( !lneg[lp][adr] ) {
+      if ( !lneg[adr] ) {
 	continue;
       }
 
-      a->adds[a->num_adds++] = lindex[lp][adr];
+      a->adds[a->num_adds++] = lindex[adr];
     }
 
     for ( i = 0; i < o->num_dels; i++ ) {
@@ -713,16 +826,19 @@ void collect_relevant_facts( void )
       }
       adr = fact_adress();
 
-      if ( !lpos[lp][adr] ) {
+      if ( !lpos[adr] ) {
 	continue;
       }
 
-      a->dels[a->num_dels++] = lindex[lp][adr];
+      a->dels[a->num_dels++] = lindex[adr];
     }
   }
 
   /* build final initial and goal representation
+   * (one entry more, as calloc( 0 ) may return NULL for an empty init or goal)
    */
+  ginitial_state.F = ( int * ) calloc( gnum_initial + 1, sizeof( int ) );
+  CHECK_PTR( ginitial_state.F );
   ginitial_state.num_F = 0;
   for ( i = 0; i < gnum_initial; i++ ) {
     lp = ginitial[i].predicate;
@@ -731,13 +847,15 @@ void collect_relevant_facts( void )
     }
     adr = fact_adress();
 
-    if ( !lneg[lp][adr] ) {
+    if ( !lneg[adr] ) {
       continue;
     }
 
-    ginitial_state.F[ginitial_state.num_F++] = lindex[lp][adr];
+    ginitial_state.F[ginitial_state.num_F++] = lindex[adr];
   }
 
+  ggoal_state.F = ( int * ) calloc( gnum_goal + 1, sizeof( int ) );
+  CHECK_PTR( ggoal_state.F );
   ggoal_state.num_F = 0;
   for ( i = 0; i < gnum_goal; i++ ) {
     lp = ggoal[i].predicate;
@@ -746,11 +864,11 @@ void collect_relevant_facts( void )
     }
     adr = fact_adress();
 
-    if ( !lneg[lp][adr] ) {
+    if ( !lneg[adr] ) {
       continue;
     }
 
-    ggoal_state.F[ggoal_state.num_F++] = lindex[lp][adr];
+    ggoal_state.F[ggoal_state.num_F++] = lindex[adr];
   }
 
   if ( gcmd_line.display_info == 110 ) {
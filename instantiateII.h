@@ -51,6 +51,11 @@ void multiply_parameters( int curr_parameter );
 
 void perform_reachability_analysis( void );
 int fact_adress( void );
+int new_fact_adress( void );
+int fact_hash_position( int p, int *args );
+void grow_fact_slots( void );
+void add_waiting( int adr, int t );
+void rehash_fact_slots( void );
 
 
 
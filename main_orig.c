@@ -186,17 +186,20 @@ FactList *gpredicates_and_types = NULL;
  *               predicate aritys,
  *               defined types of predicate args
  */
-Token gconstants[MAX_CONSTANTS];
+Token *gconstants;
 int gnum_constants = 0;
+int gmax_constants = 0;
 Token gtype_names[MAX_TYPES];
-int gtype_consts[MAX_TYPES][MAX_TYPE];
-Bool gis_member[MAX_CONSTANTS][MAX_TYPES];
+int *gtype_consts[MAX_TYPES];
+int gmax_type_size[MAX_TYPES];
+Bool (*gis_member)[MAX_TYPES];
 int gtype_size[MAX_TYPES];
 int gnum_types = 0;
-Token gpredicates[MAX_PREDICATES];
-int garity[MAX_PREDICATES];
-int gpredicates_args_type[MAX_PREDICATES][MAX_ARITY];
+Token *gpredicates;
+int *garity;
+int (*gpredicates_args_type)[MAX_ARITY];
 int gnum_predicates = 0;
+int gmax_predicates = 0;
 
 
 
@@ -204,12 +207,15 @@ int gnum_predicates = 0;
 
 /* the domain in integer (Fact) representation
  */
-Operator_pointer goperators[MAX_OPERATORS];
+Operator_pointer *goperators;
 int gnum_operators;
-Fact gfull_initial[MAX_INITIAL];
+int gmax_operators = 0;
+Fact *gfull_initial;
 int gnum_full_initial = 0;
-Fact ggoal[MAX_STATE];
+int gmax_full_initial = 0;
+Fact *ggoal;
 int gnum_goal = 0;
+int gmax_goal = 0;
 
 
 
@@ -219,21 +225,23 @@ int gnum_goal = 0;
 /* stores inertia - information: is any occurence of the predicate
  * added / deleted in the uninstantiated ops ?
  */
-Bool gis_added[MAX_PREDICATES];
-Bool gis_deleted[MAX_PREDICATES];
+Bool *gis_added;
+Bool *gis_deleted;
 
 /* splitted initial state:
  * initial non static facts,
  * initial inertia facts of arity > 1
  */
-Fact ginitial[MAX_STATE];
+Fact *ginitial;
 int gnum_initial = 0;
-Fact ginertia[MAX_INITIAL];
+int gmax_initial = 0;
+Fact *ginertia;
 int gnum_inertia = 0;
+int gmax_inertia = 0;
 
 /* the type numbers corresponding to any unary inertia
  */
-int gtype_to_predicate[MAX_PREDICATES];
+int *gtype_to_predicate;
 int gpredicate_to_type[MAX_TYPES];
 
 /* (ordered) numbers of types that new type is intersection of
@@ -257,8 +265,9 @@ int gnum_templates = 0;
 
 /* store the final "relevant facts"
  */
-Fact grelevant_facts[MAX_RELEVANT_FACTS];
+Fact *grelevant_facts;
 int gnum_relevant_facts = 0;
+int gmax_relevant_facts = 0;
 int gnum_pp_facts;
 
 
@@ -533,13 +542,6 @@ int lh2level, lreallevel;
 int main_orig( int argc, char *argv[] )
 
 {
-  /* resulting name for ops file
-   */
-  char ops_file[MAX_LENGTH] = "";
-  /* same for fct file 
-   */
-  char fct_file[MAX_LENGTH] = "";
-  
   gcmd_line.cnflayer = -1;
   gcmd_line.cnfout = -1;
   gcmd_line.solverOut = FALSE;
@@ -572,6 +574,25 @@ int main_orig( int argc, char *argv[] )
     bb_usage();      
     exit( 1 );
   }
+  return 0;
+
+}
+
+
+
+/* parsing and instantiation, once main_orig has processed the command line
+ * (not needed when the grounded task comes from a task cache, see TaskCache.h)
+ */
+int main_orig_ground( void )
+
+{
+  /* resulting name for ops file
+   */
+  char ops_file[MAX_LENGTH] = "";
+  /* same for fct file 
+   */
+  char fct_file[MAX_LENGTH] = "";
+
   /* add path info, complete file names will be stored in
    * ops_file and fct_file 
    */
@@ -782,6 +803,19 @@ void bb_usage( void )
   
   printf("-x <0 or 1> Postprocess the plan by Action Elimination: 0 - off, 1 - on (default).\n");
   
+  printf("-j <num>    Number of threads trying the actions in parallel when extending (default 1; the search itself is the same for any number).\n");
+  printf("-P <num>    Portfolio: run <num> differently configured searches in parallel and report the first one to finish (default 0 - off).\n");
+  printf("-k <num>    Portfolio members share their derived clauses of at most <num> literals (default 0 - off).\n");
+  
+  printf("-z <num>    Seed of the random orderings (default 1; portfolio member i uses <num>+i).\n");
+  printf("-w <str>    Record the random numbers drawn into the replay log <str>.\n");
+  printf("-y <str>    Replay a run recorded with -w, drawing the random numbers from the log <str>.\n");
+  printf("-J <str>    Write the statistics of every phase as a line of JSON to the file <str> (/dev/fd/<num> for a descriptor).\n");
+  printf("-T <str>    Write a trace of the search as Chrome trace events (for Perfetto) to the file <str>; needs a build with -DPDR_TRACE.\n");
+  printf("-u <num>    Trace only every <num>-th extend call and clause insertion (default 1).\n");
+  printf("-C <str>    Task cache: load the grounded task from the file <str>, or ground as usual and write it there\n");
+  printf("            (rewritten when the input files have changed since).\n");
+  
   return;
 
   printf("-i <num>    run-time information level( preset: 1 )\n");
@@ -841,6 +875,19 @@ Bool process_command_line( int argc, char *argv[] )
   gcmd_line.obl_survive = 1;  
   
   gcmd_line.postprocess = 1;
+  
+  gcmd_line.threads = 1;
+  
+  gcmd_line.portfolio = 0;
+  gcmd_line.share_clauses = 0;
+  
+  gcmd_line.seed = 1;
+  memset(gcmd_line.replay_file, 0, MAX_LENGTH);
+  gcmd_line.replay = 0;
+  memset(gcmd_line.stats_file, 0, MAX_LENGTH);
+  memset(gcmd_line.trace_file, 0, MAX_LENGTH);
+  gcmd_line.trace_sample = 1;
+  memset(gcmd_line.task_cache, 0, MAX_LENGTH);
     
   while ( --argc && ++argv ) {
     if ( *argv[0] != '-' || strlen(*argv) != 2 ) {
@@ -908,6 +955,38 @@ Bool process_command_line( int argc, char *argv[] )
   case 'x':
 	  sscanf( *argv, "%d", &gcmd_line.postprocess );
 	  break;   
+  case 'j':
+	  sscanf( *argv, "%d", &gcmd_line.threads );
+	  break;   
+  case 'P':
+	  sscanf( *argv, "%d", &gcmd_line.portfolio );
+	  break;   
+  case 'k':
+	  sscanf( *argv, "%d", &gcmd_line.share_clauses );
+	  break;   
+  case 'z':
+	  sscanf( *argv, "%u", &gcmd_line.seed );
+	  break;   
+  case 'w':
+	  strncpy( gcmd_line.replay_file, *argv, MAX_LENGTH-1 );
+	  gcmd_line.replay = 0;
+	  break;
+  case 'y':
+	  strncpy( gcmd_line.replay_file, *argv, MAX_LENGTH-1 );
+	  gcmd_line.replay = 1;
+	  break;
+  case 'J':
+	  strncpy( gcmd_line.stats_file, *argv, MAX_LENGTH-1 );
+	  break;
+  case 'T':
+	  strncpy( gcmd_line.trace_file, *argv, MAX_LENGTH-1 );
+	  break;
+  case 'u':
+	  sscanf( *argv, "%d", &gcmd_line.trace_sample );
+	  break;
+  case 'C':
+	  strncpy( gcmd_line.task_cache, *argv, MAX_LENGTH-1 );
+	  break;
     
 	default:
 	  printf( "\nbb: unknown option: %c entered\n\n", option );
@@ -303,11 +303,24 @@ Action *new_Action( int op )
 
 {
 
+  Operator *o = goperators[op];
   Action *result = ( Action * ) calloc( 1, sizeof( Action ) );
   CHECK_PTR(result);
 
   result->op = op;
 
+  if ( o->num_preconds > 0 ) {
+    result->preconds = ( int * ) calloc( o->num_preconds, sizeof( int ) );
+    CHECK_PTR(result->preconds);
+  }
+  if ( o->num_adds > 0 ) {
+    result->adds = ( int * ) calloc( o->num_adds, sizeof( int ) );
+    CHECK_PTR(result->adds);
+  }
+  if ( o->num_dels > 0 ) {
+    result->dels = ( int * ) calloc( o->num_dels, sizeof( int ) );
+    CHECK_PTR(result->dels);
+  }
   result->num_preconds = 0;
   result->num_adds = 0;
   result->num_dels = 0;
@@ -535,6 +548,41 @@ StateHashEntry *new_StateHashEntry( void )
 
 }
 
+
+
+/* doubles the table of *max facts
+ */
+Fact *grow_fact_table( Fact *table, int *max )
+
+{
+
+  int new_max = *max ? 2 * *max : INITIAL_TABLE_SIZE;
+
+  table = grow_table( table, *max, new_max, sizeof( Fact ) );
+  *max = new_max;
+
+  return table;
+
+}
+
+
+
+/* reallocates a table of size elements (of elem_size bytes each) to new_size
+ * elements, the new ones zeroed; for the growable global tables
+ */
+void *grow_table( void *table, int size, int new_size, size_t elem_size )
+
+{
+
+  char *result = ( char * ) realloc( table, ( size_t ) new_size * elem_size );
+  CHECK_PTR(result);
+
+  memset( result + ( size_t ) size * elem_size, 0, ( size_t ) ( new_size - size ) * elem_size );
+
+  return result;
+
+}
+
   
 
 
@@ -60,6 +60,8 @@ OpLevelInfo *new_OpLevelInfo( void );
 
 
 StateHashEntry *new_StateHashEntry( void );
+void *grow_table( void *table, int size, int new_size, size_t elem_size );
+Fact *grow_fact_table( Fact *table, int *max );
 
 
 